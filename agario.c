@@ -2,35 +2,30 @@
 // AUTHOR: KRISTIAN KORIBSKY
 // DATE: 8.12.2022
 // ==========================================================================
-#define _POSIX_C_SOURCE 200201L
+#define _POSIX_C_SOURCE 200809L
 
 #include "config.h"
 #include "agario.h"
 #include "name.h"
+#include "game.h"
+#include "stencil.h"
+#include "frame.h"
+#include "scheduler.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "net.h"
+#include "delta.h"
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
 #include <curses.h>
-#include <time.h>
-#include <math.h>
-#include <limits.h>
 
 
-// macros for easier color switching readability
-#define COLOR_ON(x) attron(COLOR_PAIR(x))
-#define COLOR_OFF(x) attroff(COLOR_PAIR(x))
-
-
-void sleep_ms(const int milliseconds)
-{
-    struct timespec ts = {
-        .tv_sec = milliseconds / 1000,
-        .tv_nsec = (milliseconds % 1000) * 1000000
-    };
-    nanosleep(&ts, NULL);
-}
-
-
-int str_len(char *string)
+int str_len(const char *string)
 {
     if (string == NULL)
         return -1;
@@ -43,82 +38,35 @@ int str_len(char *string)
 }
 
 
-int rand_int(const int min, const int max)
-{   
-    // prevent floating-point exception (modulo by 0), also it is unexpected behaviour when min > max (err throwing would be nice)
-    // if (min > max) return ERR;
-
-    // rand returns value between 0 and maximum integer (in int range)
-    return min + rand() % (max + 1 - min);
-}
-
-
-float distance(const int point1, const int point2)
-{
-    return sqrtf(point1*point1 + point2*point2);
-}
-
-
-bool inside_circle(const int row, const int col, const int center_row, const int center_col, const float radius)
-{
-    return distance(center_row-row, center_col-col) <= radius;
-}
-
-
-void render_circle(const int row, const int col, const float radius, const int color_pair)
-{
-    COLOR_OFF(BACKGROUND);
-    COLOR_ON(color_pair);
-
-    for (int i=row-radius; i <= row+radius; i++)
-        for (int ii=col-radius; ii <= col+radius; ii++)
-            if (inside_circle(i, ii, row, col, radius))
-                mvprintw(i, ii, " ");
-    
-    COLOR_OFF(color_pair);
-    COLOR_ON(BACKGROUND);
-}
-
-
-void render_number(const int row, const int col, char *format, const int num, const int color_pair)
+void render_circle(struct frame *frame, const int row, const int col, const float radius, const int color_pair)
 {
-    COLOR_OFF(BACKGROUND);
-    COLOR_ON(color_pair);
+    const struct stencil *stencil = stencil_get(radius);
+    if (stencil == NULL)
+        return;
 
-    mvprintw(row, col, format, num);
-    
-    COLOR_OFF(color_pair);
-    COLOR_ON(BACKGROUND);
+    // fill precomputed span of every row
+    for (int i=-stencil->rows; i <= stencil->rows; i++) {
+        int span = stencil->span[i + stencil->rows];
+        frame_span(frame, row+i, col-span, col+span, ' ', color_pair);
+    }
 }
 
 
-void render_text(const int row, const int col, char *text, const int color_pair)
+void render_number(struct frame *frame, const int row, const int col, char *format, const int num, const int color_pair)
 {
-    COLOR_OFF(BACKGROUND);
-    COLOR_ON(color_pair);
+    char text[frame->cols + 1];
+    snprintf(text, sizeof(text), format, num);
 
-    mvprintw(row, col, "%s", text);
-
-    COLOR_OFF(color_pair);
-    COLOR_ON(BACKGROUND);
+    frame_text(frame, row, col, text, color_pair);
 }
 
 
-void render_string(const int row, const int col, char *format, char *string, const int color_pair)
+void render_string(struct frame *frame, const int row, const int col, const char *format, const char *string, const int color_pair)
 {
-    COLOR_OFF(BACKGROUND);
-    COLOR_ON(color_pair);
-
-    mvprintw(row, col, format, string);
-
-    COLOR_OFF(color_pair);
-    COLOR_ON(BACKGROUND);
-}
-
+    char text[frame->cols + 1];
+    snprintf(text, sizeof(text), format, string);
 
-float get_radius(const int size)
-{
-    return size / SIZE_MODIFIER + RADIUS_MODIFIER;
+    frame_text(frame, row, col, text, color_pair);
 }
 
 
@@ -161,91 +109,6 @@ void init_colors(void)
 }
 
 
-bool check_collision(const int row, const int col, const int radius, const int size, int world[size][size])
-{
-    if (world[row][col] != EMPTY) return FALSE;
-
-    // here it is enough to do box-check, no need for circle-check
-    for(int i=row-radius; i <= row+radius; i++)
-        for (int ii=col-radius; ii <= col+radius; ii++)
-            if (i != row && ii != col && world[i][ii] != EMPTY)
-                return FALSE;
-
-    return TRUE;
-}
-
-
-float entity_spawn(int *row, int *col, const int size, int world[size][size])
-{
-    // random spawn size
-    int radius = rand_int(MIN_BASE_RADIUS, MAX_BASE_RADIUS);
-    if (radius+1 > (size-1)-radius-1) return 0;     // radius can't be bigger than world size
-
-    // try to generate TRIES number of times, then return 0 and don't spawn -> lots of collisions, world probably full
-    int r, c;
-    for (int i=0; i < TRIES; i++) {
-        r = rand_int(radius+RADIUS_MODIFIER*2, (size-1)-radius-RADIUS_MODIFIER*2); // don't spawn very close to edge
-        c = rand_int(radius+RADIUS_MODIFIER*2, (size-1)-radius-RADIUS_MODIFIER*2); // don't spawn very close to edge
-
-        if (check_collision(r, c, radius, size, world)) {
-            *row = r;
-            *col = c;
-            return radius;
-        }
-    }
-    return 0;
-}
-
-
-void blob_spawn(int *blobs, const int max_blobs, const int size, int world[size][size])
-{
-    if (*blobs >= max_blobs)
-        return;
-
-    int row = rand_int(1, (size-1)-1);
-    int col = rand_int(1, (size-1)-1);
-
-    if(check_collision(row, col, BLOB_RADIUS+1, size, world)) {
-        world[row][col] = rand_int(ENTITY_COLORS_START, ENTITY_COLORS_END);
-        *blobs += 1;
-    }
-}
-
-void update_bot_vectors(const int n, const int params, int ent[n][params], const float difficulty)
-{
-    // player position
-    int p_row = ent[PLAYER][ROW];
-    int p_col = ent[PLAYER][COL];
-
-    // loop trough living bots, not counting player
-    for (int i=PLAYER+1; i < n; i++) {
-        if (ent[i][ALIVE] == FALSE)
-            continue;
-
-        // entity position
-        int e_row = ent[i][ROW];
-        int e_col = ent[i][COL];
-        
-        // when bot is too far away from player (not in viewport) - calculate vectors randomly
-        if (abs(e_row - p_row) > LINES/2 - LINES*0.1 || abs(e_col - p_col) > COLS/2 - COLS*0.1) {
-            ent[i][ROW_VECTOR] = rand_int(-VERTICAL_MODIFIER, VERTICAL_MODIFIER);
-            ent[i][COL_VECTOR] = rand_int(-HORIZONTAL_MODIFIER, HORIZONTAL_MODIFIER);
-            continue;
-        }
-        // relative vectors pointing to player
-        int relative_row_vector = e_row > p_row ? -VERTICAL_MODIFIER : VERTICAL_MODIFIER;      
-        int relative_col_vector = e_col > p_col ? -HORIZONTAL_MODIFIER : HORIZONTAL_MODIFIER;
-
-        // calculate whether bot should chase or run away
-        int chase = ent[i][SIZE] >= ent[PLAYER][SIZE] ? 1 : -1;
-        int outcome = difficulty * 100 > rand_int(0, 100) ? chase : chase * -1;
-
-        ent[i][ROW_VECTOR] = outcome * relative_row_vector;
-        ent[i][COL_VECTOR] = outcome * relative_col_vector; 
-    }
-}
-
-
 void update_player_vectors(const int ch, int *row_vector, int *col_vector)
 {
     MEVENT event;
@@ -300,90 +163,6 @@ void update_player_vectors(const int ch, int *row_vector, int *col_vector)
 }
 
 
-void update_positions(const int n, const int params, int ent[n][params], const int size, int world[size][size])
-{
-    // iterate entity register
-    for (int i = 0; i < n; i++) {
-        if (ent[i][ALIVE] == FALSE)
-            continue;
-
-        // border checking
-        int radius = get_radius(ent[i][SIZE]);
-        int new_row = ent[i][ROW] + ent[i][ROW_VECTOR];
-        int new_col = ent[i][COL] + ent[i][COL_VECTOR];
-
-        // need to split these condtitions because of custom move speed modifiers
-        if (new_row - radius < 0)
-            new_row = radius;
-        else if (new_row + radius >= size)
-            new_row = (size-1)-radius;
-        
-        if (new_col - radius < 0)
-            new_col = radius;
-        else if (new_col + radius >= size)
-            new_col = (size-1)-radius;
-
-        // update entity in world
-        world[ent[i][ROW]][ent[i][COL]] = EMPTY;
-        world[new_row][new_col] = ENTITY_START + i;
-
-        // update ent in entities registry
-        ent[i][ROW] = new_row;
-        ent[i][COL] = new_col;   
-    }
-}
-
-
-void eval_positions(const int n, const int params, int ent[n][params], const int size, int world[size][size], int *blobs, int *alive)
-{
-    *alive = 0;     // reset counter before evaluating all entities
-    
-    // iterate entity register
-    for (int k=0; k < n; k++) {
-        if (ent[k][ALIVE] == FALSE)
-            continue;
-        
-        *alive += 1;
-
-        int row = ent[k][ROW];
-        int col = ent[k][COL];
-        float radius = get_radius(ent[k][SIZE]);
-
-        // get bigger of the two modifiers to account for that in hitboxes (to prevent jumping over the hitbox)
-        int modiff = HORIZONTAL_MODIFIER > VERTICAL_MODIFIER ? HORIZONTAL_MODIFIER : VERTICAL_MODIFIER;
-        modiff -= 1;    // base modifier starts at 1
-
-        // collision evalutation algorithm: iterate & evaluate every index along the circle's circumference
-        for (int i=row-radius-modiff; i <= row+radius+modiff; i++) {
-            for (int ii=col-radius-modiff; ii <= col+radius+modiff; ii++) {
-                float d = distance(row - i, col - ii);
-
-                if (d >= radius-modiff-1 && d <= radius) {
-                    if (world[i][ii] == EMPTY) {
-                        continue;
-                        
-                    } else if (world[i][ii] >= BLOB_START && world[i][ii] < ENTITY_START) {
-                        ent[k][SIZE] += 1;
-                        *blobs -= 1;
-                        world[i][ii] = EMPTY;
-                    
-                    // if current's entity circumference reached centre of other entity before the other did so,
-                    // radius and thus size of current entity is bigger, therefore eliminate given entity
-                    // if the 2 radii are equal, nothing happens
-                    } else if (world[i][ii] >= ENTITY_START) {
-                        if (get_radius(ent[k][SIZE]) > get_radius(ent[world[i][ii] - ENTITY_START][SIZE])) {
-                            ent[world[i][ii] - ENTITY_START][ALIVE] = FALSE;
-                            ent[k][SIZE] += ent[world[i][ii] - ENTITY_START][SIZE] * GROW_MODIFIER;
-                            world[i][ii] = EMPTY;
-                        }
-                    }
-                }
-            }
-        }
-    }
-}
-
-
 bool heading_menu(char *head, char *option1, char *option2)
 {
     int head_len = str_len(head);
@@ -536,190 +315,241 @@ void input_menu(char *label, const int input_len, char input[input_len])
 }
 
 
-void render_viewport(const int n, const int params, int ent[n][params], const int len, char ent_names[n][len], const int size, int world[size][size], const int bots)
+void render_viewport(struct frame *frame, const struct entities *ent, const char *const ent_names[], const struct world *world, const int player, const int bots, const struct profile *profile)
 {
+    if (frame_begin(frame, BACKGROUND))
+        return;
+
+    int size = world->size;
+
     // relative upper-left corner of world to viewport
-    int y = ent[PLAYER][ROW] - LINES/2;
-    int x = ent[PLAYER][COL] - COLS/2;
+    int y = ent->row[player] - frame->lines/2;
+    int x = ent->col[player] - frame->cols/2;
 
     // entities buffer because entities need to be drawn after the background
-    int render_buffer[n][3];     // 0 -> index, 1 -> world row, 2 -> world col = 3
+    // centre of every buffered entity takes its own cell of the viewport, so the buffer never outgrows the screen
+    int cells = frame->lines * frame->cols;
+    int render_buffer[ent->n < cells ? ent->n : cells][3];     // 0 -> index, 1 -> world row, 2 -> world col = 3
     int buffer_i = 0;
 
     // viewport is always centered on player
     // render background & save blobs & entities to buffer
-    for (int i=0; i < LINES; i++)
-            for (int ii=0; ii < COLS; ii++)
-                // check if viewport is inside world
-                if (y+i >= 0 && y+i < size && x+ii >= 0 && x+ii < size) {
-                    int index = world[y+i][x+ii];
-                    // empty
-                    if (index == EMPTY) {
-                        mvprintw(i, ii, " ");
-                    // blob
-                    } else if (index >= BLOB_START && index < ENTITY_START) {
-                        render_circle(i, ii, BLOB_RADIUS, index);       // render blob here since it will always have size of 1
-                    // entity
-                    } else {
-                        // save entity to buffer to be rendered later
-                        if (ent[index - ENTITY_START][ALIVE]) {
-                            render_buffer[buffer_i][0] = index;
-                            render_buffer[buffer_i][1] = i;
-                            render_buffer[buffer_i][2] = ii;
-                            buffer_i++;
-                        }
-                    }
-                // if viewport outside of the world, render black pixels
-                } else {
-                    render_text(i, ii, " ", BLACK);
+    for (int i=0; i < frame->lines; i++) {
+        // if viewport outside of the world, render black spans
+        if (y+i < 0 || y+i >= size) {
+            frame_span(frame, i, 0, frame->cols-1, ' ', BLACK);
+            continue;
+        }
+        int left = x < 0 ? -x : 0;
+        int right = x+frame->cols > size ? size-1-x : frame->cols-1;
+        frame_span(frame, i, 0, left-1, ' ', BLACK);
+        frame_span(frame, i, right+1, frame->cols-1, ' ', BLACK);
+
+        for (int ii=left; ii <= right; ii++) {
+            int index = world_get(world, y+i, x+ii);
+            // empty - frame is already filled with background
+            if (index == EMPTY) {
+                continue;
+            // blob
+            } else if (index >= BLOB_START && index < ENTITY_START) {
+                render_circle(frame, i, ii, BLOB_RADIUS, index);       // render blob here since it will always have size of 1
+            // entity
+            } else {
+                // save entity to buffer to be rendered later
+                if (ent->alive[index - ENTITY_START]) {
+                    render_buffer[buffer_i][0] = index;
+                    render_buffer[buffer_i][1] = i;
+                    render_buffer[buffer_i][2] = ii;
+                    buffer_i++;
                 }
+            }
+        }
+    }
     
     // render blobs & entities
     for (int i=0; i < buffer_i; i++) {
         int index = render_buffer[i][0];
         int row = render_buffer[i][1];
         int col = render_buffer[i][2];
-        render_circle(row, col, get_radius(ent[index - ENTITY_START][SIZE]), ent[index - ENTITY_START][COLOR]);
+        render_circle(frame, row, col, get_radius(ent->size[index - ENTITY_START]), ent->color[index - ENTITY_START]);
 
-        int radius = get_radius(ent[index - ENTITY_START][SIZE]);
-        render_string(row - radius - 2, col - str_len(ent_names[index - ENTITY_START])/2, "%s", ent_names[index - ENTITY_START], TEXT_CLR);
+        int radius = get_radius(ent->size[index - ENTITY_START]);
+        render_string(frame, row - radius - 2, col - str_len(ent_names[index - ENTITY_START])/2, "%s", ent_names[index - ENTITY_START], TEXT_CLR);
     }
 
     // game state info
-    render_number(LINES-2, 0, "ENEMIES LEFT: %d", bots, TEXT_CLR);
-    render_number(LINES-1, 0, "YOUR SIZE: %d", ent[PLAYER][SIZE], TEXT_CLR);
+    render_number(frame, frame->lines-2, 0, "ENEMIES LEFT: %d", bots, TEXT_CLR);
+
+    render_number(frame, frame->lines-1, 0, "YOUR SIZE: %d", ent->size[player], TEXT_CLR);
+
+    // profiler statistics next to the enemies counter, tick start jitter next to the size
+    if (profile != NULL) {
+        long min, avg, p99, jitter_avg, jitter_max;
+        profile_stats(profile, &min, &avg, &p99);
+        profile_jitter_stats(profile, &jitter_avg, &jitter_max);
 
-    // IMPORTANT TO CALL CURSES' REFRESH FOR UPDATES
-    refresh();
+        char stats[PROFILE_HUD_LEN];
+        snprintf(stats, sizeof(stats), "TICK MIN/AVG/P99: %.2f/%.2f/%.2f ms", min / 1e6, avg / 1e6, p99 / 1e6);
+        render_string(frame, frame->lines-2, snprintf(NULL, 0, "ENEMIES LEFT: %d", bots) + 3, "%s", stats, TEXT_CLR);
+        snprintf(stats, sizeof(stats), "JITTER AVG/MAX: %.2f/%.2f ms", jitter_avg / 1e6, jitter_max / 1e6);
+        render_string(frame, frame->lines-1, snprintf(NULL, 0, "YOUR SIZE: %d", ent->size[player]) + 3, "%s", stats, TEXT_CLR);
+    }
+
+    // send only damaged cells to the screen
+    frame_flush(frame);
 }
 
 
-void agario(const int world_size, const int max_bots)
+void agario(const struct options *options)
 {
     // Init
     // ==========================================================================
     init_screen();
     init_colors();
 
-    newgame:
-    // init world
-    int world[world_size][world_size];
-    for (int i=0; i < world_size; i++)
-        for (int ii=0; ii < world_size; ii++)
-            world[i][ii] = EMPTY;
-
-    // init entities
-    int line, max_length;
-    int ent_count = max_bots+PLAYERS;
-    random_line(&line, &max_length);
-    char ent_names[ent_count][max_length];
-
-    int ent_alive = 0;
-    int ent_row, ent_col, ent_radius;
-    int ent[ent_count][PARAMS];
-    for (int i=0; i < ent_count; i++) {
-        ent_radius = entity_spawn(&ent_row, &ent_col, world_size, world);
-
-        ent[i][ROW] = ent_row;
-        ent[i][COL] = ent_col;
-        ent[i][ROW_VECTOR] = 0;
-        ent[i][COL_VECTOR] = 0;
-        ent[i][SIZE] = ent_radius * SIZE_MODIFIER;
-        ent[i][ALIVE] = ent[i][SIZE] > 0 ? TRUE : FALSE;
-        ent[i][COLOR] = rand_int(ENTITY_COLORS_START, ENTITY_COLORS_END);
-
-        // add living entity to world marked with its unique index starting from ENTITY START (player is at ENTITY_START)
-        if (ent[i][ALIVE]) {
-            world[ent[i][ROW]][ent[i][COL]] = ENTITY_START + i;
-            ent_alive++;
-        }
+    // game is allocated once & reused by every new game, the first one can be continued from a snapshot
+    struct game *game = options->load != NULL ? snapshot_load(options->load) : game_create(options->world_size, options->bots, options->seed);
+    if (game == NULL && options->load != NULL) {
+        endwin();
+        printf("Snapshot %s could not be loaded.\n", options->load);
+        exit(EXIT_FAILURE);
+    }
+    struct frame *frame = frame_create();
+    if (game != NULL && options->profile != NULL)
+        game->profile = profile_create();
 
-        // entity name
-        random_line(&line, &max_length);
-        get_line(line, max_length, ent_names[i]);
+    if (game == NULL || frame == NULL || (options->profile != NULL && game->profile == NULL)) {
+        frame_destroy(frame);
+        game_destroy(game);
+        endwin();
+        printf("Not enough memory to create the world.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (game_threads(game, options->threads)) {
+        frame_destroy(frame);
+        game_destroy(game);
+        endwin();
+        printf("Threads could not be started.\n");
+        exit(EXIT_FAILURE);
     }
-    ent_names[PLAYER][0] = '\0';
+    struct entities *ent = game->ent;
 
-    // init blobs
-    int blobs = 0;
-    int blobs_max = world_size / BLOB_MAX_RATIO + 1;
-    // spawn more blobs at once in the beggining
-    for (int i=0; i < blobs_max-1; i++)
-        blob_spawn(&blobs, blobs_max, world_size, world);
+    // every game of this run is recorded into a single replay
+    struct replay *replay = NULL;
+    if (options->record != NULL && (replay = replay_create(options->record, options->seed, options->world_size, options->bots)) == NULL) {
+        frame_destroy(frame);
+        game_destroy(game);
+        endwin();
+        printf("Replay %s could not be created.\n", options->record);
+        exit(EXIT_FAILURE);
+    }
+
+    // name list is read once, missing file only leaves bots unnamed
+    struct names *names = names_load(NAMELIST_FILENAME);
+    struct rng names_rng;
+    rng_stream(&names_rng, options->seed, NAMES_STREAM);
+    const char *ent_names[ent->n];
+    char player_name[MAX_NICKNAME_LEN];
+
+    // checkpoints are written by a forked process, at most one at a time
+    pid_t checkpoint = 0;
+    bool checkpoint_failed = false;
+    bool loaded = options->load != NULL;
+
+    newgame:
+    // init world, entities & blobs
+    if (!loaded)
+        game_reset(game);
+    loaded = false;
+
+    // entity names, player name is filled in by the nickname menu
+    player_name[0] = '\0';
+    ent_names[PLAYER] = player_name;
+    for (int i=PLAYERS; i < ent->n; i++)
+        ent_names[i] = names_random(names, &names_rng);
 
     // Menus
     // ==========================================================================
     // first time menu - displays already generated world in the background
-    COLOR_ON(BACKGROUND);
-    render_viewport(max_bots + PLAYERS, PARAMS, ent, max_length, ent_names, world_size, world, ent_alive - PLAYERS);
-    COLOR_OFF(BACKGROUND);
+    frame_invalidate(frame);
+    render_viewport(frame, ent, ent_names, game->world, PLAYER, game->alive - PLAYERS, NULL);
 
     // intial menu & user response
     int res = heading_menu(WELCOME_TEXT, PLAY_GAME_TEXT, EXIT_TEXT);
-    if(res == FALSE) {
-        endwin();
-        return;
-    }
+    if(res == FALSE)
+        goto quit;
     
     // re-render map between menu change
-    COLOR_ON(BACKGROUND);
-    render_viewport(max_bots + PLAYERS, PARAMS, ent, max_length, ent_names, world_size, world, ent_alive - PLAYERS);
-    COLOR_OFF(BACKGROUND);
+    frame_invalidate(frame);
+    render_viewport(frame, ent, ent_names, game->world, PLAYER, game->alive - PLAYERS, NULL);
 
     // get name from user
-    input_menu(NICKNAME_LABEL_TEXT, MAX_NICKNAME_LEN, ent_names[PLAYER]);
+    input_menu(NICKNAME_LABEL_TEXT, MAX_NICKNAME_LEN, player_name);
 
     // re-render map between menu change
-    COLOR_ON(BACKGROUND);
-    render_viewport(max_bots + PLAYERS, PARAMS, ent, max_length, ent_names, world_size, world, ent_alive - PLAYERS);
-    COLOR_OFF(BACKGROUND);
+    frame_invalidate(frame);
+    render_viewport(frame, ent, ent_names, game->world, PLAYER, game->alive - PLAYERS, NULL);
 
     // get bot difficulty level
     int option = menu(BOT_HEADING_TEXT, BOT_EASY_TEXT, BOT_MEDIUM_TEXT, BOT_HARD_TEXT);
-    double bot_difficulty = BOT_HARD;
+    game->difficulty = BOT_HARD;
 
     switch(option) {
         case 1:
-            bot_difficulty = BOT_EASY;
+            game->difficulty = BOT_EASY;
             break;
         
         case 2:
-            bot_difficulty = BOT_MEDIUM;
+            game->difficulty = BOT_MEDIUM;
             break;
         
         case 3:
-            bot_difficulty = BOT_HARD;
+            game->difficulty = BOT_HARD;
             break;
     }
+    if (replay != NULL)
+        replay_record(replay, REPLAY_GAME, game->ticks, 0, 0, game->difficulty);
 
     // Game loop
     // ==========================================================================
     gameloop:
-    COLOR_ON(BACKGROUND);
+    frame_invalidate(frame);    // screen needs to be fully redrawn after the pause menu
     int end_delay = END_DELAY * 1000 / TICK_RATE;                 
     int ch;
-    unsigned long ticks = 0;
+    struct scheduler scheduler;
+    scheduler_start(&scheduler, TICK_RATE);
     while ((ch = getch()) != MENU_KEY && end_delay > 0) {
+        // lateness of this tick was measured by the previous wait
+        if (game->profile != NULL) {
+            profile_tick(game->profile, game->ticks);
+            profile_jitter(game->profile, scheduler.jitter);
+        }
 
-        if (ticks % BLOB_UPDATE_RATE == 0)
-            blob_spawn(&blobs, blobs_max, world_size, world);
+        if (ch != ERR) {
+            PROFILED(game->profile, PHASE_PLAYER_VECTORS, update_player_vectors(ch, &ent->row_vector[PLAYER], &ent->col_vector[PLAYER]));
+            if (replay != NULL)
+                replay_record(replay, REPLAY_INPUT, game->ticks, ent->row_vector[PLAYER], ent->col_vector[PLAYER], 0);
+        }
 
-        if (ticks % VECTOR_UPDATE_RATE == 0)
-            update_bot_vectors(ent_count, PARAMS, ent, bot_difficulty);
-                
-        if (ch != ERR)
-            update_player_vectors(ch, &ent[PLAYER][ROW_VECTOR], &ent[PLAYER][COL_VECTOR]);
+        game_tick(game);
 
-        update_positions(ent_count, PARAMS, ent, world_size, world);
-        eval_positions(ent_count, PARAMS, ent, world_size, world, &blobs, &ent_alive);
-        render_viewport(ent_count, PARAMS, ent, max_length, ent_names, world_size, world, ent_alive-PLAYERS);
+        // rendering is skipped when the tick took too long, simulation keeps the constant speed
+        if (scheduler_render(&scheduler))
+            PROFILED(game->profile, PHASE_RENDER, render_viewport(frame, ent, ent_names, game->world, PLAYER, game->alive-PLAYERS, game->profile));
         
         // game end delay
-        if (!ent[PLAYER][ALIVE] || ent_alive <= PLAYERS)
+        if (game_over(game))
             end_delay--;
 
-        ticks = ticks >= ULONG_MAX - 1 ? 0 : ticks+1; // update tick & overflow protection
-        sleep_ms(TICK_RATE);
+        if (options->checkpoint != NULL && game->ticks % CHECKPOINT_RATE == 0)
+            checkpoint_failed |= snapshot_checkpoint(game, options->checkpoint, &checkpoint);
+
+        // ticks can't be paced anymore, game would run at the full speed
+        if (scheduler_wait(&scheduler)) {
+            endwin();
+            printf("Ticks could not be scheduled.\n");
+            exit(EXIT_FAILURE);
+        }
     }
 
     // Game pause || End of the game
@@ -734,14 +564,250 @@ void agario(const int world_size, const int max_bots)
             new_game = TRUE;
     // game end
     else  {
-        char *message = ent[PLAYER][ALIVE] ? GAME_WON_TEXT : GAME_LOST_TEXT;
+        char *message = ent->alive[PLAYER] ? GAME_WON_TEXT : GAME_LOST_TEXT;
         
         if (heading_menu(message, NEW_GAME_TEXT, EXIT_TEXT))
             new_game = TRUE;
     }
 
+    if (replay != NULL)
+        replay_record(replay, REPLAY_END, game->ticks, 0, 0, 0);
+
     if(new_game)
         goto newgame;
 
+    quit:
+    names_destroy(names);
+    frame_destroy(frame);
+    stencil_free();
     endwin();   // de-init window on exit
+
+    if (game->profile != NULL && profile_dump(game->profile, options->profile))
+        printf("Profiler trace could not be written to %s.\n", options->profile);
+    if (replay_close(replay))
+        printf("Replay could not be written to %s.\n", options->record);
+    if (snapshot_wait(&checkpoint) || checkpoint_failed)
+        printf("Checkpoint could not be written to %s.\n", options->checkpoint);
+    game_destroy(game);
+}
+
+
+void agario_replay(const struct options *options)
+{
+    struct replay *replay = replay_load(options->replay);
+    if (replay == NULL) {
+        printf("Replay %s could not be loaded.\n", options->replay);
+        exit(EXIT_FAILURE);
+    }
+
+    // Init
+    // ==========================================================================
+    init_screen();
+    init_colors();
+
+    struct game *game = game_create(replay->header.world_size, replay->header.bots, replay->header.seed);
+    struct frame *frame = frame_create();
+    if (game != NULL && options->profile != NULL)
+        game->profile = profile_create();
+
+    if (game == NULL || frame == NULL || (options->profile != NULL && game->profile == NULL)) {
+        frame_destroy(frame);
+        game_destroy(game);
+        replay_close(replay);
+        endwin();
+        printf("Not enough memory to create the world.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (game_threads(game, options->threads)) {
+        frame_destroy(frame);
+        game_destroy(game);
+        replay_close(replay);
+        endwin();
+        printf("Threads could not be started.\n");
+        exit(EXIT_FAILURE);
+    }
+    struct entities *ent = game->ent;
+
+    // names are drawn from the same stream as in the recorded run
+    struct names *names = names_load(NAMELIST_FILENAME);
+    struct rng names_rng;
+    rng_stream(&names_rng, replay->header.seed, NAMES_STREAM);
+    const char *ent_names[ent->n];
+
+    // Playback
+    // ==========================================================================
+    // every tick is rendered & the next one follows immediately, MENU_KEY stops the playback
+    float difficulty;
+    int ch = ERR;
+    while (ch != MENU_KEY && replay_next_game(replay, &difficulty)) {
+        game_reset(game);
+        game->difficulty = difficulty;
+
+        ent_names[PLAYER] = REPLAY_PLAYER_NAME;
+        for (int i=PLAYERS; i < ent->n; i++)
+            ent_names[i] = names_random(names, &names_rng);
+
+        frame_invalidate(frame);
+        while ((ch = getch()) != MENU_KEY) {
+            if (game->profile != NULL)
+                profile_tick(game->profile, game->ticks);
+
+            bool playing;
+            PROFILED(game->profile, PHASE_PLAYER_VECTORS, playing = replay_input(replay, game->ticks, &ent->row_vector[PLAYER], &ent->col_vector[PLAYER]));
+            if (!playing)
+                break;
+
+            game_tick(game);
+            PROFILED(game->profile, PHASE_RENDER, render_viewport(frame, ent, ent_names, game->world, PLAYER, game->alive-PLAYERS, game->profile));
+        }
+    }
+
+    names_destroy(names);
+    frame_destroy(frame);
+    stencil_free();
+    endwin();   // de-init window on exit
+
+    if (game->profile != NULL && profile_dump(game->profile, options->profile))
+        printf("Profiler trace could not be written to %s.\n", options->profile);
+    replay_close(replay);
+    game_destroy(game);
+}
+
+
+// waits for the welcome of the server, it needs to describe a world this client can hold
+// spectators don't get any entity of their own
+static bool welcome(const int fd, struct buffer *in, struct message_welcome *welcome, const bool spectating)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    struct message_header header;
+    const char *body;
+
+    bool received = false;
+    while (!received && poll(&pfd, 1, NET_TIMEOUT) > 0) {
+        int closed = net_receive(fd, in, SIZE_MAX);
+        received = net_next(in, &header, &body);
+        if (closed && !received)
+            return false;
+    }
+    if (!received || header.type != MESSAGE_WELCOME || header.bytes != sizeof(struct message_welcome))
+        return false;
+
+    memcpy(welcome, body, sizeof(struct message_welcome));
+    return welcome->version == NET_VERSION && welcome->world_size >= MIN_WORLD_SIZE && welcome->world_size <= MAX_WORLD_SIZE
+        && welcome->entities >= PLAYERS && welcome->entities <= MAX_BOT_COUNT+PLAYERS
+        && (spectating ? welcome->entity == -1 : welcome->entity >= 0 && welcome->entity < welcome->entities);
+}
+
+
+// spectator's viewport follows the biggest living entity
+static int biggest_entity(const struct entities *ent)
+{
+    int biggest = PLAYER;
+    for (int i=0; i < ent->n; i++)
+        if (ent->alive[i] && (!ent->alive[biggest] || ent->size[i] > ent->size[biggest]))
+            biggest = i;
+
+    return biggest;
+}
+
+
+void agario_connect(const struct options *options)
+{
+    // Init
+    // ==========================================================================
+    init_screen();
+    init_colors();
+
+    // spectator only watches, it neither has a name nor sends anything
+    const bool spectating = options->connect == NULL;
+    const char *path = spectating ? options->watch : options->connect;
+
+    // name is entered before joining, server doesn't wait for the client
+    char player_name[MAX_NICKNAME_LEN];
+    player_name[0] = '\0';
+    if (!spectating)
+        input_menu(NICKNAME_LABEL_TEXT, MAX_NICKNAME_LEN, player_name);
+
+    struct buffer in = {0}, out = {0};
+    struct message_welcome settings;
+    int fd = net_connect(path);
+    if (fd < 0 || !welcome(fd, &in, &settings, spectating)) {
+        if (fd >= 0)
+            close(fd);
+        buffer_free(&in);
+        endwin();
+        printf("Server %s could not be joined.\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    struct mirror *mirror = mirror_create(settings.world_size, settings.entities);
+    struct frame *frame = frame_create();
+    if (mirror == NULL || frame == NULL) {
+        close(fd);
+        buffer_free(&in);
+        mirror_destroy(mirror);
+        frame_destroy(frame);
+        endwin();
+        printf("Not enough memory to create the world.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // every client draws names of all entities from the seed of the server, so the names are the same everywhere
+    struct names *names = names_load(NAMELIST_FILENAME);
+    struct rng names_rng;
+    rng_stream(&names_rng, settings.seed, NAMES_STREAM);
+    const char *ent_names[settings.entities];
+    for (int i=0; i < settings.entities; i++)
+        ent_names[i] = names_random(names, &names_rng);
+    if (!spectating)
+        ent_names[settings.entity] = player_name;
+
+    // Game loop
+    // ==========================================================================
+    // ticks are paced by the server, client waits for its updates at most for a tick so input keeps being read
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int row_vector = 0, col_vector = 0;
+    bool connected = true;
+    int ch;
+    frame_invalidate(frame);
+    while (connected && (ch = getch()) != MENU_KEY) {
+        if (ch != ERR && !spectating) {
+            int last_row = row_vector, last_col = col_vector;
+            update_player_vectors(ch, &row_vector, &col_vector);
+
+            struct message_input input = { .row_vector = row_vector, .col_vector = col_vector };
+            if ((row_vector != last_row || col_vector != last_col) && buffer_message(&out, MESSAGE_INPUT, &input, sizeof(input)))
+                connected = false;
+        }
+        connected = connected && net_send(fd, &out) == 0;
+
+        // updates of the server are taken whole, keyframe of a big world may take megabytes
+        poll(&pfd, 1, TICK_RATE);
+        connected = connected && net_receive(fd, &in, SIZE_MAX) == 0;
+
+        // every pending update is applied, only the last state is rendered
+        struct message_header header;
+        const char *body;
+        bool updated = false;
+        while (connected && net_next(&in, &header, &body)) {
+            connected = mirror_apply(mirror, &header, body) == 0;
+            updated = true;
+        }
+        if (connected && updated) {
+            int followed = spectating ? biggest_entity(mirror->ent) : settings.entity;
+            render_viewport(frame, mirror->ent, ent_names, mirror->world, followed, mirror->alive - PLAYERS, NULL);
+        }
+    }
+
+    close(fd);
+    buffer_free(&in);
+    buffer_free(&out);
+    names_destroy(names);
+    frame_destroy(frame);
+    mirror_destroy(mirror);
+    stencil_free();
+    endwin();   // de-init window on exit
+
+    if (!connected)
+        printf("Connection to the server %s was lost.\n", path);
 }
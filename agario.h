@@ -4,15 +4,9 @@
 // ==========================================================================
 #include <stdbool.h>
 
-
-/**
- * Compact UNIX sleep function.
- * Pauses main thread execution for miliseconds amount of time.
- * @implements nanosleep() from <time.h>
- * @param miliseconds amount of time to pause for
- * 
-*/
-void sleep_ms(const int miliseconds);
+#include "game.h"
+#include "frame.h"
+#include "scheduler.h"
 
 
 /**
@@ -21,49 +15,24 @@ void sleep_ms(const int miliseconds);
  * @param string pointer to a char (array)
  * @returns -1 if pointer is NULL, otherwise length of a string
 */
-int str_len(char *string);
-
-
-/**
- * Generates pseudo-random int from the given incluvive range.
- * I used this simple algorithm from ballsortpuzzle problem set.
- * @param min minimum generated number
- * @param max maximum generated number
- * @returns randomly generated integer
-*/
-int rand_int(const int min, const int max);
-
-
-/**
- * Calculates distance between two points in a plane using Pythagorean theorem.
- * @returns square root of point1 - point2 squared
-*/
-float distance(const int point1, const int point2);
-
-
-/**
- * Decides whether given target points are within the distance of radius.
- * @param row 'y' coordinate of target point
- * @param col 'x' coordinate of target point
- * @param center_row 'y' coordinate of circle center
- * @param center_col 'x' coordinate of circle center
- * @returns true if target points is inside circle, false otherwise
-*/
-bool inside_circle(const int row, const int col, const int center_row, const int center_col, const float radius);
+int str_len(const char *string);
 
 
 /**
- * Displays circle at the given position.
+ * Draws circle at the given position into the frame.
+ * @implements stencil_get() - filled rows of circle are precomputed per radius
+ * @param frame frame to draw into
  * @param row 'y' coordinate of circle center
  * @param col 'x' coordinate of circle center
  * @param radius radius of a circle
  * @param color_pair number of color pair to use (must be initialized beforehand)
 */
-void render_circle(const int row, const int col, const float radius, const int color_pair);
+void render_circle(struct frame *frame, const int row, const int col, const float radius, const int color_pair);
 
 
 /**
- * Displays text with number at the given position.
+ * Draws text with number at the given position into the frame.
+ * @param frame frame to draw into
  * @param row 'y' coordinate of text on the screen
  * @param col 'x' coordinate of text on the screen
  * @param format text containing format
@@ -71,37 +40,19 @@ void render_circle(const int row, const int col, const float radius, const int c
  * @param color_pair number of color pair to use (must be initialized beforehand)
  */
 
-void render_number(const int row, const int col, char *format, const int num, const int color_pair);
+void render_number(struct frame *frame, const int row, const int col, char *format, const int num, const int color_pair);
 
 
 /**
- * Displays text at the given position.
- * @param row 'y' coordinate of text on the screen
- * @param col 'x' coordinate of text on the screen
- * @param text text to be displayed
- * @param color_pair number of color pair to use (must be initialized beforehand)
- */
-
-void render_text(const int row, const int col, char *text, const int color_pair);
-
-
-/**
- * Displays string at the given position.
+ * Draws string at the given position into the frame.
+ * @param frame frame to draw into
  * @param row 'y' coordinate of text on the screen
  * @param col 'x' coordinate of text on the screen
  * @param format text containing format
  * @param string string to be used with the format
  * @param color_pair number of color pair to use (must be initialized beforehand)
 */
-void render_string(const int row, const int col, char *format, char *string, const int color_pair);
-
-
-/**
- *
- * Calculates radius using the entity's size.
- * @param size size of entity
- */
-float get_radius(const int size);
+void render_string(struct frame *frame, const int row, const int col, const char *format, const char *string, const int color_pair);
 
 
 // WINDOW *init_screen(void);
@@ -117,56 +68,6 @@ void init_screen(void);
 void init_colors(void);
 
 
-/**
- * Detects other entities inside the given entity.
- * @attention Blobs do not count as an entity.
- * @attention It is implicit that given row & col +- radius inside the world bounds.
- * @attention This function doesn't take into account possible differences in radius, therefore it is only suitable on world spawn.
- * @param row 'y' coordinate of entity
- * @param col 'x' coordinate of entity
- * @param radius size of entity
- * @param size size of world
- * @param world map of a world containing entity indexes
- * @returns true if there is any entity within given radius, false otherwise
- */
-bool check_collision(const int row, const int col, const int radius, const int size, int world[size][size]);
-
-
-/**
- * Spawns entities on random coordinates in the world.
- * @implements check_collision() to prevent spawning inside one another.
- * @param row pointer to store randomly generated row
- * @param col pointer to store randomly generated col
- * @param size size of world
- * @param world map of a world containing entity indexes - used for collision detection
- * @returns randomly generated radius of spawned entity after successful generation, 0 otherwise
- */
-float entity_spawn(int *row, int *col, const int size, int world[size][size]);
-
-
-/**
- * Tries to randomly generate blob inside world.
- * Functions prevents spawning blob next to another blob.
- * @param blobs pointer to an amount of blobs already spawned
- * @param max_blobs maximum amount of blobs allowed to be spawned at the same time
- * @param size size of the world
- * @param world map of a world
-*/
-void blob_spawn(int *blobs, const int max_blobs, const int size, int world[size][size]);
-
-
-/**
- * Bot vectors calculated according to player position & player size.
- * Bigger bots will generally more often head towards player while smaller ones will try to run away.
- * @attention To make game more interesting some degree of randomness is integrated in calculations.
- * @param n number of entities
- * @param params number of entity parameters
- * @param ent array of all entities (player & bots)
- * @param difficulty bot difficulty level
- */
-void update_bot_vectors(const int n, const int params, int ent[n][params], const float difficulty);
-
-
 /**
  * Updates player movement according to inputs.
  * Supports 2 input types: mouse (8 directions) / arrow keys (4 directions)
@@ -179,32 +80,6 @@ void update_bot_vectors(const int n, const int params, int ent[n][params], const
 void update_player_vectors(const int ch, int *row_vector, int *col_vector);
 
 
-/**
- * Updates positions of entities in both world & entities registry.
- * Moves entities in direction according to their vectors.
- * @param n number of entities
- * @param params number of entity parameters
- * @param ent array of all entities (player & bots)
- * @param size size of the world
- * @param world map of a world containing entity indexes
- *
- */
-void update_positions(const int n, const int params, int ent[n][params], const int size, int world[size][size]);
-
-
-/**
- * Performs collision evaluation with other entities & blobs.
- * @param n number of entities
- * @param params number of entity parameters
- * @param ent array of all entities (player & bots)
- * @param size size of the world
- * @param world map of a world containing entity indexes
- * @param blobs pointer to update blobs counter if entity picked up a blob
- * @param alive pointer to entities alive for updating
- */
-void eval_positions(const int n, const int params, int ent[n][params], const int size, int world[size][size], int *blobs, int *alive);
-
-
 /**
  * Displays menu with given heading and 2 options.
  * There are 2 options, user selects option by pressing SUBMIT_KEY.
@@ -245,25 +120,46 @@ void input_menu(char *label, const int input_len, char input[input_len]);
 
 /**
  * Renders part of the world, filling entire viewport.
- * Player is always in the centre of world.
+ * Given player is always in the centre of world.
  * @attention That means the world could be rendered even behind bounds when player is near the edge.
- * @param n number of entities
- * @param params number of entity parameters
- * @param ent array of all entities (player & bots)
- * @param len size of names buffer
+ * Viewport is composed in the frame first, only cells changed since the last frame are sent to the screen.
+ * @param frame frame buffer of the screen
+ * @param ent registry of all entities (player & bots)
  * @param ent_names array containing entity names
- * @param size size of the world
  * @param world map of a world containing entity indexes
+ * @param player entity in the centre of the viewport (PLAYER, or entity steered by the client of a server)
  * @param bots bots alive for displaying on screen
+ * @param profile profiler for displaying tick statistics next to bots alive, NULL to hide them
  */
-void render_viewport(const int n, const int params, int ent[n][params], const int len, char ent_names[n][len], const int size, int world[size][size], const int bots);
+void render_viewport(struct frame *frame, const struct entities *ent, const char *const ent_names[], const struct world *world, const int player, const int bots, const struct profile *profile);
 
 
 /**
  * Starts interactive agar.io game
- * @param world_size dimensions of the generated world - usually larger than viewport
- * @param max_bots number of bots to generate inside the world
+ * The first game is continued from options->load snapshot when given.
+ * When checkpoints are enabled, snapshot of the running game is written every CHECKPOINT_RATE ticks.
+ * When profiling is enabled, tick statistics are displayed & trace is written on exit.
+ * @param options game settings (world size is usually larger than viewport)
 */
-void agario(const int world_size, const int max_bots);
+void agario(const struct options *options);
+
 
+/**
+ * Plays back recorded replay in terminal.
+ * Ticks are not throttled, every tick is simulated & rendered right after the previous one.
+ * Playback can be stopped with MENU_KEY.
+ * When profiling is enabled, tick statistics are displayed & trace is written on exit.
+ * @param options game settings, replay file is given in options->replay
+ */
+void agario_replay(const struct options *options);
 
+
+/**
+ * Joins multiplayer server & plays on it in terminal.
+ * Client only sends directions of its entity, world is rendered from updates received from the server.
+ * Updates received since the last render are applied at once, so a slow terminal skips frames instead of lagging behind.
+ * Spectator (options->watch) sends nothing, its viewport follows the biggest living entity.
+ * Game is left with MENU_KEY.
+ * @param options game settings, socket of the server is given in options->connect (or spectator socket in options->watch)
+ */
+void agario_connect(const struct options *options);
@@ -5,9 +5,10 @@
 // game
 #define GAME_PARAMETERS 2
 #define MIN_WORLD_SIZE 100
-#define MAX_WORLD_SIZE 1200
+#define MAX_WORLD_SIZE 100000
 #define MIN_BOT_COUNT 0
-#define MAX_BOT_COUNT 1000
+#define MAX_BOT_COUNT 100000
+#define MAX_THREADS 64
 
 #define MENU_KEY KEY_BACKSPACE  // curses key for pausing/displaying menu
 #define SUBMIT_KEY '\n'         // key for submitting menu option
@@ -26,6 +27,7 @@
 #define EXIT_TEXT "Exit"
 
 #define NICKNAME_LABEL_TEXT "Enter your name: "
+#define REPLAY_PLAYER_NAME "REPLAY"     // name of the player in played back replay
 
 #define BOT_HEADING_TEXT "Choose bot difficulty:"
 #define BOT_EASY_TEXT "EASY"
@@ -34,19 +36,58 @@
 
 // timing
 #define TICK_RATE 60            // miliseconds between game updates
-#define BLOB_UPDATE_RATE 20     // game ticks to wait after spawning new blob
+#define BLOB_UPDATE_RATE 20     // game ticks to wait after spawning new blobs
 #define VECTOR_UPDATE_RATE 5    // game ticks to wait after updating bot directions
 #define END_DELAY 2             // how many seconds to wait until game will end after winning/loosing
+#define MAX_FRAMESKIP 5         // maximum number of renders skipped in a row when game falls behind
+#define MAX_TICK_LAG 10         // ticks the game can fall behind before the schedule is reset
+#define PROFILE_TICKS 1024      // number of last ticks kept by profiler
+#define PROFILE_HUD_LEN 64      // maximum length of profiler statistics line
+
+// replay
+#define REPLAY_MAGIC "AGRP"     // first bytes of every replay file
+#define REPLAY_VERSION 1        // version of replay file format, older replays are refused
+
+// snapshot
+#define SNAPSHOT_MAGIC "AGSV"   // first bytes of every snapshot file
+#define SNAPSHOT_VERSION 2      // version of snapshot file format, older snapshots are refused
+#define SNAPSHOT_BYTE_ORDER 0x01020304  // snapshots are stored in native byte order, this value tells it apart
+#define SNAPSHOT_TEMPORARY ".tmp"       // suffix of checkpoint being written
+#define CHECKPOINT_RATE 1000    // game ticks between 2 checkpoints
+
+// server
+#define NET_VERSION 1           // version of server messages, clients of other versions are refused
+#define NET_RECEIVE 65536       // bytes received from a socket at once
+#define NET_TIMEOUT 5000        // miliseconds client waits for the welcome of the server
+#define SERVER_BACKLOG 16       // connections waiting to be accepted by the server
+#define MAX_CLIENTS 64          // clients steering entities of a single server
+#define CLIENT_BACKLOG (4 << 20)    // bytes waiting to be sent to a client (or parsed) before the client is dropped
+
+// spectators
+#define FEED_SLOTS 64           // updates of the game loop waiting for the fan-out thread, older ones are overwritten
+#define FEED_LAG 32             // updates a viewer may lag behind before it skips ahead with a keyframe
+#define FEED_HISTORY 128        // updates kept for viewers by the fan-out thread (at least FEED_SLOTS + FEED_LAG)
+#define MAX_VIEWERS 512         // spectators watching a single server
 
 // generator
 #define PLAYERS 1               // number of players (current implementation supports only 1 player)
 #define TRIES 2                 // number of times generator will try to randomly spawn entity (after that the world is probably full)
 #define BLOB_MAX_RATIO 2        // ratio to determine maximum number of blobs existing at the same time
+#define BLOB_BATCH_RATIO 100    // up to (maximum number of blobs / ratio + 1) blobs spawned at once during the game
+#define BLOB_TRIES 8            // free cells tried for a single blob before giving up
+#define NAMES_STREAM 1          // random stream of entity names, kept apart from the simulation (stream 0)
 
 // world
 #define EMPTY 0                 // empty position in the world
 #define BLOB_START 1            // each blob will have its color represented by index
 #define ENTITY_START 10         // players & bots identified by index
+#define ENTITY_CELL 255         // world cell occupied by an entity, index is kept in world's side table
+#define SPATIAL_CELL 16         // side of a spatial index bucket (entity broad-phase)
+#define BLOB_CELL 16            // side of a world bucket with counted blobs (blob search)
+#define CHUNK 64                // side of a lazily allocated world chunk (a single 64-bit occupancy word per row)
+#define PARALLEL_TILES 16       // tiles of the world per thread in parallel evaluation (for load balancing)
+#define PARALLEL_MIN 256        // entities alive needed for parallel evaluation
+#define SPAWN_CHUNK 1024        // entities placed by a worker at once during world generation
 
 // movement
 #define HORIZONTAL_MODIFIER 2   // modifies horizontal movement speed
@@ -61,15 +102,6 @@
 #define GROW_MODIFIER 0.5       // how much size increases after consuming other entity's size
 
 // entities = players & bots
-#define PARAMS 7                // number of parameters stored for each entity
-#define ROW 0
-#define COL 1
-#define ROW_VECTOR 2
-#define COL_VECTOR 3
-#define SIZE 4
-#define ALIVE 5
-#define COLOR 6
-
 #define PLAYER 0                // player's index in entities & world array
 
 // bots
@@ -77,6 +109,12 @@
 #define BOT_EASY 0.3
 #define BOT_MEDIUM 0.7
 #define BOT_HARD 0.98  
+// decisions of every bot per VECTOR_UPDATE_RATE ticks, grows with difficulty level from min to max
+#define BOT_MIN_DECISIONS 1.0
+#define BOT_MAX_DECISIONS 2.0
+#define BOT_VISION 20           // how far bots see other entities (beyond their own radius)
+#define BOT_NEIGHBOURS 8        // nearest entities considered by a bot in one decision
+#define BOT_BLOB_VISION 40      // how far bots see blobs (beyond their own radius)
 
 // colors
 #define RED 1
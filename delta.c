@@ -0,0 +1,304 @@
+// IMPLEMENTATION of library "delta.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "config.h"
+#include "delta.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+struct delta *delta_create(const int n)
+{
+    struct delta *delta = calloc(1, sizeof(struct delta));
+    if (delta == NULL)
+        return NULL;
+
+    delta->n = n;
+    delta->row = calloc(n, sizeof(int));
+    delta->col = calloc(n, sizeof(int));
+    delta->size = calloc(n, sizeof(int));
+    delta->color = calloc(n, sizeof(int));
+    delta->alive = calloc(n, sizeof(bool));
+    delta->cell = calloc(n, sizeof(int));
+    if (delta->row == NULL || delta->col == NULL || delta->size == NULL || delta->color == NULL || delta->alive == NULL
+        || delta->cell == NULL) {
+        delta_destroy(delta);
+        return NULL;
+    }
+
+    return delta;
+}
+
+
+void delta_destroy(struct delta *delta)
+{
+    if (delta == NULL)
+        return;
+
+    free(delta->row);
+    free(delta->col);
+    free(delta->size);
+    free(delta->color);
+    free(delta->alive);
+    free(delta->cell);
+    free(delta);
+}
+
+
+// appends message with the given state, its records follow & their counts are filled in by finish()
+// position of the message is relative to the pending bytes, which may be moved while the buffer grows
+static int begin(struct buffer *out, const enum message_type type, const unsigned long tick, const int alive, size_t *at)
+{
+    struct message_state state = { .tick = tick, .alive = alive };
+
+    *at = out->len - out->start;
+    return buffer_message(out, type, &state, sizeof(state));
+}
+
+
+static void finish(struct buffer *out, const size_t at, const int entities, const int cells)
+{
+    char *message = out->data + out->start + at;
+    struct message_header header;
+    struct message_state state;
+    memcpy(&header, message, sizeof(header));
+    memcpy(&state, message + sizeof(header), sizeof(state));
+
+    header.bytes = sizeof(state) + entities * sizeof(struct message_entity) + cells * sizeof(struct message_cell);
+    state.entities = entities;
+    state.cells = cells;
+    memcpy(message, &header, sizeof(header));
+    memcpy(message + sizeof(header), &state, sizeof(state));
+}
+
+
+static int send_entity(const struct entities *ent, const int i, struct buffer *out)
+{
+    struct message_entity record = {
+        .index = i, .row = ent->row[i], .col = ent->col[i], .size = ent->size[i], .color = ent->color[i], .alive = ent->alive[i]
+    };
+
+    return buffer_append(out, &record, sizeof(record));
+}
+
+
+// remembers every entity & cell in its centre as they were sent
+static void remember(struct delta *delta, const struct entities *ent, const struct world *world)
+{
+    memcpy(delta->row, ent->row, ent->n * sizeof(int));
+    memcpy(delta->col, ent->col, ent->n * sizeof(int));
+    memcpy(delta->size, ent->size, ent->n * sizeof(int));
+    memcpy(delta->color, ent->color, ent->n * sizeof(int));
+    memcpy(delta->alive, ent->alive, ent->n * sizeof(bool));
+
+    for (int k=0; k < ent->live_count; k++) {
+        int i = ent->live[k];
+        delta->cell[i] = world_get(world, ent->row[i], ent->col[i]);
+    }
+}
+
+
+static int send_cell(const struct world *world, const int row, const int col, struct buffer *out)
+{
+    struct message_cell record = { .row = row, .col = col, .value = world_get(world, row, col) };
+
+    return buffer_append(out, &record, sizeof(record));
+}
+
+
+// encodes every living entity & every cell which is not EMPTY
+static int keyframe(const struct world *world, const struct entities *ent, const unsigned long tick, const int alive, struct buffer *out)
+{
+    size_t at;
+    if (begin(out, MESSAGE_KEYFRAME, tick, alive, &at))
+        return 1;
+
+    int entities = 0;
+    for (int i=0; i < ent->n; i++) {
+        if (!ent->alive[i])
+            continue;
+        if (send_entity(ent, i, out))
+            return 1;
+        entities++;
+    }
+
+    // every occupied cell of allocated chunks
+    int cells = 0;
+    long chunks = (long)world->chunk_cols * world->chunk_cols;
+    for (long c=0; c < chunks; c++) {
+        const struct chunk *chunk = world->chunks[c];
+        if (chunk == NULL)
+            continue;
+
+        int top = (c / world->chunk_cols) * CHUNK;
+        int left = (c % world->chunk_cols) * CHUNK;
+        for (int r=0; r < CHUNK; r++)
+            for (uint64_t bits = chunk->occupied[r]; bits != 0; bits &= bits - 1) {
+                if (send_cell(world, top + r, left + __builtin_ctzll(bits), out))
+                    return 1;
+                cells++;
+            }
+    }
+
+    finish(out, at, entities, cells);
+    return 0;
+}
+
+
+int delta_keyframe(struct delta *delta, const struct game *game, struct buffer *out)
+{
+    if (keyframe(game->world, game->ent, game->ticks, game->alive, out))
+        return 1;
+
+    remember(delta, game->ent, game->world);
+    return 0;
+}
+
+
+int delta_update(struct delta *delta, const struct game *game, struct buffer *out)
+{
+    const struct entities *ent = game->ent;
+    const struct world *world = game->world;
+
+    size_t at;
+    if (begin(out, MESSAGE_DELTA, game->ticks, game->alive, &at))
+        return 1;
+
+    // entities are compared against the previous update, cells left or entered by them follow
+    int entities = 0;
+    for (int i=0; i < ent->n; i++) {
+        if (ent->alive[i] == delta->alive[i] && (!ent->alive[i] || (ent->row[i] == delta->row[i] && ent->col[i] == delta->col[i]
+            && ent->size[i] == delta->size[i] && ent->color[i] == delta->color[i])))
+            continue;
+
+        if (send_entity(ent, i, out))
+            return 1;
+        entities++;
+    }
+
+    int cells = 0;
+    for (int i=0; i < ent->n; i++) {
+        bool moved = ent->row[i] != delta->row[i] || ent->col[i] != delta->col[i];
+        if (!delta->alive[i] && !ent->alive[i])
+            continue;
+
+        // entity eliminated right after its move left both cells
+        if (delta->alive[i] && (!ent->alive[i] || moved)) {
+            if (send_cell(world, delta->row[i], delta->col[i], out))
+                return 1;
+            cells++;
+        }
+        // centre of an entity which stayed in place can be rewritten too, eg. when other entity left the same cell
+        if (!delta->alive[i] || moved || (ent->alive[i] && world_get(world, ent->row[i], ent->col[i]) != delta->cell[i])) {
+            if (send_cell(world, ent->row[i], ent->col[i], out))
+                return 1;
+            cells++;
+        }
+    }
+
+    // blobs spawned & eaten during the tick
+    const struct events *events = game->events;
+    for (int e=0; e < events->count; e++) {
+        const struct event *event = &events->queue[e];
+        if (event->type != EVENT_BLOB_SPAWN && event->type != EVENT_BLOB_EATEN)
+            continue;
+
+        if (send_cell(world, event->row, event->col, out))
+            return 1;
+        cells++;
+    }
+
+    remember(delta, ent, world);
+    finish(out, at, entities, cells);
+    return 0;
+}
+
+
+struct mirror *mirror_create(const int world_size, const int n)
+{
+    struct mirror *mirror = calloc(1, sizeof(struct mirror));
+    if (mirror == NULL)
+        return NULL;
+
+    mirror->world = world_create(world_size);
+    mirror->ent = entities_create(n);
+    if (mirror->world == NULL || mirror->ent == NULL) {
+        mirror_destroy(mirror);
+        return NULL;
+    }
+
+    return mirror;
+}
+
+
+void mirror_destroy(struct mirror *mirror)
+{
+    if (mirror == NULL)
+        return;
+
+    world_destroy(mirror->world);
+    entities_destroy(mirror->ent);
+    free(mirror);
+}
+
+
+int mirror_apply(struct mirror *mirror, const struct message_header *header, const char *body)
+{
+    struct world *world = mirror->world;
+    struct entities *ent = mirror->ent;
+
+    struct message_state state;
+    if ((header->type != MESSAGE_KEYFRAME && header->type != MESSAGE_DELTA) || header->bytes < sizeof(state))
+        return 1;
+
+    memcpy(&state, body, sizeof(state));
+    if (state.entities < 0 || state.entities > ent->n || state.cells < 0
+        || header->bytes != sizeof(state) + (size_t)state.entities * sizeof(struct message_entity) + (size_t)state.cells * sizeof(struct message_cell))
+        return 1;
+
+    // keyframe starts from an empty world, delta can be applied only on top of it
+    if (header->type == MESSAGE_KEYFRAME) {
+        world_reset(world, world->size, NULL);
+        entities_clear(ent);
+        mirror->synced = true;
+    } else if (!mirror->synced) {
+        return 1;
+    }
+    body += sizeof(state);
+
+    for (int i=0; i < state.entities; i++, body += sizeof(struct message_entity)) {
+        struct message_entity record;
+        memcpy(&record, body, sizeof(record));
+        if (record.index < 0 || record.index >= ent->n || record.row < 0 || record.row >= world->size
+            || record.col < 0 || record.col >= world->size || record.size < 0)
+            return 1;
+
+        ent->row[record.index] = record.row;
+        ent->col[record.index] = record.col;
+        ent->size[record.index] = record.size;
+        ent->color[record.index] = record.color;
+        ent->alive[record.index] = record.alive;
+    }
+
+    for (int i=0; i < state.cells; i++, body += sizeof(struct message_cell)) {
+        struct message_cell record;
+        memcpy(&record, body, sizeof(record));
+        if (record.row < 0 || record.row >= world->size || record.col < 0 || record.col >= world->size
+            || record.value < EMPTY || record.value >= ENTITY_START + ent->n)
+            return 1;
+
+        world_set(world, record.row, record.col, record.value);
+    }
+
+    mirror->ticks = state.tick;
+    mirror->alive = state.alive;
+    return 0;
+}
+
+
+int mirror_keyframe(const struct mirror *mirror, struct buffer *out)
+{
+    return keyframe(mirror->world, mirror->ent, mirror->ticks, mirror->alive, out);
+}
@@ -0,0 +1,157 @@
+// LIBRARY "delta.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "net.h"
+
+
+/**
+ * Body of MESSAGE_KEYFRAME & MESSAGE_DELTA.
+ * It is followed by the given number of entity records (struct message_entity) & cell records (struct message_cell).
+ * Keyframe holds every living entity & every cell which is not EMPTY, client starts from an empty world.
+ * Delta holds only entities & cells changed since the previous update, so it costs nothing when nothing moves.
+ */
+struct message_state {
+    uint64_t tick;              // game tick of the update
+    int32_t alive;              // entities alive (player included)
+    int32_t entities;           // number of entity records
+    int32_t cells;              // number of cell records
+    int32_t unused;
+};
+
+
+/**
+ * Entity record of a state update.
+ */
+struct message_entity {
+    int32_t index;              // entity index
+    int32_t row;
+    int32_t col;
+    int32_t size;
+    uint8_t color;
+    uint8_t alive;
+    uint16_t unused;
+};
+
+
+/**
+ * Cell record of a state update.
+ */
+struct message_cell {
+    int32_t row;
+    int32_t col;
+    int32_t value;              // EMPTY, blob color or ENTITY_START + entity index
+};
+
+
+/**
+ * Encoder of state updates on the server.
+ * Entities are remembered as they were sent with the last update, changed ones are found by comparing against them.
+ * Entities are the only ones writing cells besides blob events, so changed cells are the centres of moved, eliminated
+ * or rewritten entities & cells of blob events of the tick.
+ */
+struct delta {
+    int n;                      // number of entities
+    int *row;
+    int *col;
+    int *size;
+    int *color;
+    bool *alive;
+    int *cell;                  // cell in the centre of every living entity
+};
+
+
+/**
+ * Copy of the game state on the client, built only from received updates.
+ */
+struct mirror {
+    struct world *world;        // cells of the server's world
+    struct entities *ent;       // entities of the server, live list isn't kept
+    unsigned long ticks;        // game tick of the last update
+    int alive;                  // entities alive (player included)
+    bool synced;                // keyframe was received, so deltas can be applied
+};
+
+
+/**
+ * Allocates encoder of state updates.
+ * @param n number of entities
+ * @returns pointer to the allocated encoder, NULL if memory could not be allocated
+ */
+struct delta *delta_create(const int n);
+
+
+/**
+ * Frees encoder of state updates.
+ * @param delta encoder to free (NULL is allowed)
+ */
+void delta_destroy(struct delta *delta);
+
+
+/**
+ * Appends MESSAGE_KEYFRAME with the whole state of the game into the buffer.
+ * Non-EMPTY cells are found on occupancy bitmaps of allocated chunks, so the cost grows with the content of the world.
+ * @param delta encoder of the game
+ * @param game game to encode
+ * @param out buffer to append the message to
+ * @returns 0 if everything ok, 1 if memory could not be allocated
+ */
+int delta_keyframe(struct delta *delta, const struct game *game, struct buffer *out);
+
+
+/**
+ * Appends MESSAGE_DELTA with changes since the previous update into the buffer.
+ * @attention it needs to be called after every tick (events of the tick are read), previous update needs to be from the previous tick
+ * @param delta encoder of the game
+ * @param game game to encode
+ * @param out buffer to append the message to
+ * @returns 0 if everything ok, 1 if memory could not be allocated
+ */
+int delta_update(struct delta *delta, const struct game *game, struct buffer *out);
+
+
+/**
+ * Allocates empty copy of the game state.
+ * @param world_size dimensions of the world
+ * @param n number of entities
+ * @returns pointer to the allocated copy, NULL if memory could not be allocated
+ */
+struct mirror *mirror_create(const int world_size, const int n);
+
+
+/**
+ * Frees copy of the game state.
+ * @param mirror copy to free (NULL is allowed)
+ */
+void mirror_destroy(struct mirror *mirror);
+
+
+/**
+ * Applies MESSAGE_KEYFRAME or MESSAGE_DELTA to the copy of the game state.
+ * Every record is checked, so a broken update never writes outside of the world.
+ * @param mirror copy of the game state
+ * @param header header of the message
+ * @param body body of the message
+ * @returns 0 if everything ok, 1 if the update is malformed or comes before the first keyframe
+ */
+int mirror_apply(struct mirror *mirror, const struct message_header *header, const char *body);
+
+
+/**
+ * Appends MESSAGE_KEYFRAME with the whole copy of the game state into the buffer, eg. for a client joining later.
+ * @attention copy needs to be synced
+ * @param mirror copy of the game state
+ * @param out buffer to append the message to
+ * @returns 0 if everything ok, 1 if memory could not be allocated
+ */
+int mirror_keyframe(const struct mirror *mirror, struct buffer *out);
+
+
+#endif
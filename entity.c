@@ -0,0 +1,76 @@
+// IMPLEMENTATION of library "entity.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "entity.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+struct entities *entities_create(const int n)
+{
+    struct entities *ent = calloc(1, sizeof(struct entities));
+    if (ent == NULL)
+        return NULL;
+
+    ent->n = n;
+    ent->row = calloc(n, sizeof(int));
+    ent->col = calloc(n, sizeof(int));
+    ent->row_vector = calloc(n, sizeof(int));
+    ent->col_vector = calloc(n, sizeof(int));
+    ent->size = calloc(n, sizeof(int));
+    ent->color = calloc(n, sizeof(int));
+    ent->alive = calloc(n, sizeof(bool));
+    ent->live = calloc(n, sizeof(int));
+
+    if (ent->row == NULL || ent->col == NULL || ent->row_vector == NULL || ent->col_vector == NULL
+        || ent->size == NULL || ent->color == NULL || ent->alive == NULL || ent->live == NULL) {
+        entities_destroy(ent);
+        return NULL;
+    }
+
+    return ent;
+}
+
+
+void entities_clear(struct entities *ent)
+{
+    memset(ent->alive, false, ent->n * sizeof(bool));
+    ent->live_count = 0;
+}
+
+
+void entities_destroy(struct entities *ent)
+{
+    if (ent == NULL)
+        return;
+
+    free(ent->row);
+    free(ent->col);
+    free(ent->row_vector);
+    free(ent->col_vector);
+    free(ent->size);
+    free(ent->color);
+    free(ent->alive);
+    free(ent->live);
+    free(ent);
+}
+
+
+void entities_add(struct entities *ent, const int i)
+{
+    ent->alive[i] = true;
+    ent->live[ent->live_count++] = i;
+}
+
+
+void entities_compact(struct entities *ent)
+{
+    int count = 0;
+    for (int k=0; k < ent->live_count; k++)
+        if (ent->alive[ent->live[k]])
+            ent->live[count++] = ent->live[k];
+
+    ent->live_count = count;
+}
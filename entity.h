@@ -0,0 +1,69 @@
+// LIBRARY "entity.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef ENTITY_H
+#define ENTITY_H
+
+#include <stdbool.h>
+
+
+/**
+ * Registry of all entities (players & bots) stored as structure of arrays.
+ * Each parameter has its own contiguous array indexed by entity index, so every pass touches only fields it needs.
+ * Living entities are additionally kept in dense list, per-tick passes iterate only this list.
+ */
+struct entities {
+    int n;              // number of entities (capacity of every array)
+    int *row;           // 'y' coordinate
+    int *col;           // 'x' coordinate
+    int *row_vector;    // vertical movement
+    int *col_vector;    // horizontal movement
+    int *size;          // size (radius is derived from size)
+    int *color;         // color pair
+    bool *alive;        // liveness flag
+
+    int *live;          // dense list of living entity indexes, in ascending order
+    int live_count;     // number of entities in live list
+};
+
+
+/**
+ * Allocates registry for n entities, all of them dead.
+ * @param n number of entities
+ * @returns pointer to the allocated registry, NULL if memory could not be allocated
+ */
+struct entities *entities_create(const int n);
+
+
+/**
+ * Marks every entity as dead & empties live list.
+ * @param ent registry to clear
+ */
+void entities_clear(struct entities *ent);
+
+
+/**
+ * Frees registry.
+ * @param ent registry to free (NULL is allowed)
+ */
+void entities_destroy(struct entities *ent);
+
+
+/**
+ * Marks entity as alive & appends it to live list.
+ * @attention entities need to be added in ascending order of their indexes
+ * @param i entity index
+ */
+void entities_add(struct entities *ent, const int i);
+
+
+/**
+ * Removes entities which died since the last call from live list.
+ * Order of remaining entities is preserved.
+ * @param ent registry to compact
+ */
+void entities_compact(struct entities *ent);
+
+
+#endif
@@ -0,0 +1,55 @@
+// IMPLEMENTATION of library "event.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "event.h"
+
+#include <stdlib.h>
+
+
+struct events *events_create(const int capacity)
+{
+    struct events *events = calloc(1, sizeof(struct events));
+    if (events == NULL)
+        return NULL;
+
+    events->queue = malloc(capacity * sizeof(struct event));
+    if (events->queue == NULL) {
+        free(events);
+        return NULL;
+    }
+
+    events->capacity = capacity;
+    return events;
+}
+
+
+void events_destroy(struct events *events)
+{
+    if (events == NULL)
+        return;
+
+    free(events->queue);
+    free(events);
+}
+
+
+void events_clear(struct events *events)
+{
+    events->count = 0;
+    events->applied = 0;
+}
+
+
+void events_push(struct events *events, const enum event_type type, const int entity, const int other, const int row, const int col)
+{
+    if (events->count == events->capacity)
+        return;     // capacity is computed from game limits, this never happens
+
+    struct event *event = &events->queue[events->count++];
+    event->type = type;
+    event->entity = entity;
+    event->other = other;
+    event->row = row;
+    event->col = col;
+}
@@ -0,0 +1,77 @@
+// LIBRARY "event.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef EVENT_H
+#define EVENT_H
+
+
+// changes of game state emitted by the simulation
+enum event_type {
+    EVENT_SPAWN,                // entity was spawned into the world
+    EVENT_BLOB_SPAWN,           // blob was spawned into the world
+    EVENT_BLOB_EATEN,           // entity picked up a blob
+    EVENT_KILL,                 // entity eliminated other entity (death of the other one)
+};
+
+
+/**
+ * Single change of game state.
+ */
+struct event {
+    enum event_type type;
+    int entity;                 // entity causing the event, -1 for blob spawn
+    int other;                  // eliminated entity of EVENT_KILL, -1 otherwise
+    int row;                    // position of spawned entity/blob, eaten blob or eliminated entity
+    int col;
+};
+
+
+/**
+ * Queue of events emitted during one game tick.
+ * Capacity is fixed, so that pushing an event never allocates.
+ */
+struct events {
+    struct event *queue;
+    int count;                  // number of queued events
+    int capacity;               // maximum number of queued events
+    int applied;                // events already applied to game counters (see game_events())
+};
+
+
+/**
+ * Allocates empty event queue.
+ * @param capacity maximum number of events queued at the same time
+ * @returns pointer to the allocated queue, NULL if memory could not be allocated
+ */
+struct events *events_create(const int capacity);
+
+
+/**
+ * Frees event queue.
+ * @param events queue to free (NULL is allowed)
+ */
+void events_destroy(struct events *events);
+
+
+/**
+ * Removes every event from the queue.
+ * @param events queue to clear
+ */
+void events_clear(struct events *events);
+
+
+/**
+ * Appends event to the queue.
+ * @attention queue needs to have free capacity
+ * @param events queue to append to
+ * @param type type of the event
+ * @param entity entity causing the event, -1 for blob spawn
+ * @param other eliminated entity of EVENT_KILL, -1 otherwise
+ * @param row position of the event
+ * @param col position of the event
+ */
+void events_push(struct events *events, const enum event_type type, const int entity, const int other, const int row, const int col);
+
+
+#endif
@@ -0,0 +1,319 @@
+// IMPLEMENTATION of library "feed.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "feed.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+
+// updates taken out of the ring at once must not overwrite the ones viewers may still send
+_Static_assert(FEED_SLOTS + FEED_LAG <= FEED_HISTORY, "feed history is too short");
+
+
+// wakes up the fan-out thread
+static void wake(struct feed *feed)
+{
+    const char byte = 0;
+
+    // full pipe already wakes the thread up
+    if (write(feed->wake[1], &byte, 1) < 0 && errno != EAGAIN)
+        fprintf(stderr, "Spectator feed could not be woken up.\n");
+}
+
+
+static void drop(struct viewer *viewer)
+{
+    close(viewer->fd);
+    buffer_free(&viewer->out);
+    viewer->fd = -1;
+}
+
+
+// takes new updates out of the ring & applies them to the mirror
+static void take(struct feed *feed)
+{
+    struct mirror *mirror = feed->mirror;
+    bool lost = false;
+
+    // slots are only exchanged with unused buffers of the history, so the game loop never waits for a copy
+    // unused buffer (with its memory) goes to the ring & is reused by the following publish
+    const unsigned long first = feed->count;
+    pthread_mutex_lock(&feed->lock);
+    if (feed->published - feed->taken > FEED_SLOTS) {
+        feed->taken = feed->published - FEED_SLOTS;
+        lost = true;
+    }
+    int taken = 0;
+    for (; feed->taken < feed->published; feed->taken++, taken++) {
+        struct buffer *slot = &feed->ring[feed->taken % FEED_SLOTS];
+        struct buffer *update = &feed->history[(first + taken) % FEED_HISTORY];
+        struct buffer tmp = *update;
+        *update = *slot;
+        *slot = tmp;
+    }
+    pthread_mutex_unlock(&feed->lock);
+
+    // publish leaves the slot empty when the update didn't fit
+    for (int i=0; i < taken; i++) {
+        const struct buffer *update = &feed->history[(first + i) % FEED_HISTORY];
+        lost |= update->start == update->len;
+    }
+
+    // deltas can't be applied after lost updates, they are skipped until the requested keyframe comes
+    if (lost) {
+        mirror->synced = false;
+        atomic_store(&feed->resync, true);
+    }
+
+    // applied updates stay in the history, the other ones are overwritten by the following ones
+    for (int i=0; i < taken; i++) {
+        struct buffer *update = &feed->history[(first + i) % FEED_HISTORY];
+        struct message_header header;
+        const char *body;
+
+        size_t start = update->start;
+        bool applied = net_next(update, &header, &body) && mirror_apply(mirror, &header, body) == 0;
+        update->start = start;
+        if (!applied)
+            continue;
+
+        struct buffer *kept = &feed->history[feed->count % FEED_HISTORY];
+        if (kept != update) {
+            struct buffer tmp = *kept;
+            *kept = *update;
+            *update = tmp;
+        }
+        feed->count++;
+    }
+}
+
+
+static void accept_viewers(struct feed *feed)
+{
+    int fd;
+
+    while ((fd = accept(feed->fd, NULL, NULL)) >= 0) {
+        struct viewer *viewer = NULL;
+        for (int i=0; i < MAX_VIEWERS && viewer == NULL; i++)
+            if (feed->viewers[i].fd == -1)
+                viewer = &feed->viewers[i];
+
+        if (viewer == NULL || fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+            close(fd);
+            continue;
+        }
+
+        *viewer = (struct viewer){ .fd = fd, .keyframe = true };
+        if (buffer_message(&viewer->out, MESSAGE_WELCOME, &feed->welcome, sizeof(feed->welcome)))
+            drop(viewer);
+    }
+}
+
+
+// tells whether the viewer has a message to take, same rules as in refill()
+static bool waiting(const struct feed *feed, const struct viewer *viewer)
+{
+    if (viewer->out.start < viewer->out.len)
+        return true;
+    if (viewer->keyframe || feed->count - viewer->next > FEED_LAG)
+        return feed->mirror->synced;
+    return viewer->next < feed->count;
+}
+
+
+// puts the next message for the viewer into its buffer
+// @returns 1 if there is a message, 0 if viewer is up to date, -1 if memory could not be allocated
+static int refill(struct feed *feed, struct viewer *viewer)
+{
+    const struct buffer *message = NULL;
+
+    // joining & lagging viewers skip ahead to the current state of the mirror
+    if (viewer->keyframe || feed->count - viewer->next > FEED_LAG) {
+        if (!feed->mirror->synced)
+            return 0;
+
+        if (feed->keyframe_at != feed->count) {
+            feed->keyframe.start = feed->keyframe.len = 0;
+            if (mirror_keyframe(feed->mirror, &feed->keyframe))
+                return -1;
+            feed->keyframe_at = feed->count;
+        }
+        message = &feed->keyframe;
+        viewer->next = feed->count;
+        viewer->keyframe = false;
+    } else if (viewer->next < feed->count) {
+        message = &feed->history[viewer->next++ % FEED_HISTORY];
+    } else {
+        return 0;
+    }
+
+    return buffer_append(&viewer->out, message->data + message->start, message->len - message->start) ? -1 : 1;
+}
+
+
+// sends messages until the viewer is up to date or its socket is full
+static int serve(struct feed *feed, struct viewer *viewer)
+{
+    do {
+        int refilled = viewer->out.start == viewer->out.len ? refill(feed, viewer) : 1;
+        if (refilled <= 0)
+            return refilled < 0;
+
+        if (net_send(viewer->fd, &viewer->out))
+            return 1;
+    } while (viewer->out.start == viewer->out.len);
+
+    return 0;
+}
+
+
+static void *fan_out(void *arg)
+{
+    struct feed *feed = arg;
+    struct pollfd fds[MAX_VIEWERS + 2];
+    int polled[MAX_VIEWERS];
+
+    while (!atomic_load(&feed->quit)) {
+        // viewers are polled for writing only while they have something to take, hang up is reported always
+        int n = 0;
+        fds[n++] = (struct pollfd){ .fd = feed->wake[0], .events = POLLIN };
+        fds[n++] = (struct pollfd){ .fd = feed->fd, .events = POLLIN };
+        for (int i=0; i < MAX_VIEWERS; i++) {
+            const struct viewer *viewer = &feed->viewers[i];
+            if (viewer->fd == -1)
+                continue;
+
+            polled[n-2] = i;
+            fds[n++] = (struct pollfd){ .fd = viewer->fd, .events = waiting(feed, viewer) ? POLLOUT : 0 };
+        }
+        if (poll(fds, n, -1) < 0)
+            continue;
+
+        // every wake up is handled at once
+        char wakes[64];
+        ssize_t woken;
+        do {
+            woken = read(feed->wake[0], wakes, sizeof(wakes));
+        } while (woken > 0);
+
+        take(feed);
+        accept_viewers(feed);
+
+        for (int k=2; k < n; k++) {
+            struct viewer *viewer = &feed->viewers[polled[k-2]];
+            if ((fds[k].revents & (POLLHUP | POLLERR)) || serve(feed, viewer))
+                drop(viewer);
+        }
+
+        // viewers accepted right now get their welcome without waiting for the next update
+        for (int i=0; i < MAX_VIEWERS; i++)
+            if (feed->viewers[i].fd != -1 && feed->viewers[i].keyframe && serve(feed, &feed->viewers[i]))
+                drop(&feed->viewers[i]);
+    }
+
+    return NULL;
+}
+
+
+struct feed *feed_create(const char *path, const struct game *game)
+{
+    struct feed *feed = calloc(1, sizeof(struct feed));
+    if (feed == NULL)
+        return NULL;
+
+    feed->path = path;
+    feed->fd = -1;
+    feed->wake[0] = feed->wake[1] = -1;
+    feed->keyframe_at = ULONG_MAX;
+    for (int i=0; i < MAX_VIEWERS; i++)
+        feed->viewers[i].fd = -1;
+
+    feed->welcome = (struct message_welcome){
+        .version = NET_VERSION, .world_size = game->world->size, .entities = game->ent->n, .entity = -1, .seed = game->seed
+    };
+    atomic_init(&feed->resync, true);
+    atomic_init(&feed->quit, false);
+    pthread_mutex_init(&feed->lock, NULL);
+
+    feed->mirror = mirror_create(game->world->size, game->ent->n);
+    if (feed->mirror == NULL || pipe(feed->wake) != 0 || fcntl(feed->wake[0], F_SETFL, O_NONBLOCK) != 0
+        || fcntl(feed->wake[1], F_SETFL, O_NONBLOCK) != 0 || (feed->fd = net_listen(path)) < 0
+        || pthread_create(&feed->thread, NULL, fan_out, feed) != 0) {
+        if (feed->fd >= 0) {
+            close(feed->fd);
+            unlink(path);
+        }
+        if (feed->wake[0] >= 0) {
+            close(feed->wake[0]);
+            close(feed->wake[1]);
+        }
+        mirror_destroy(feed->mirror);
+        pthread_mutex_destroy(&feed->lock);
+        free(feed);
+        return NULL;
+    }
+
+    return feed;
+}
+
+
+void feed_destroy(struct feed *feed)
+{
+    if (feed == NULL)
+        return;
+
+    atomic_store(&feed->quit, true);
+    wake(feed);
+    pthread_join(feed->thread, NULL);
+
+    for (int i=0; i < MAX_VIEWERS; i++)
+        if (feed->viewers[i].fd != -1)
+            drop(&feed->viewers[i]);
+    for (int i=0; i < FEED_SLOTS; i++)
+        buffer_free(&feed->ring[i]);
+    for (int i=0; i < FEED_HISTORY; i++)
+        buffer_free(&feed->history[i]);
+    buffer_free(&feed->keyframe);
+
+    close(feed->fd);
+    unlink(feed->path);
+    close(feed->wake[0]);
+    close(feed->wake[1]);
+    mirror_destroy(feed->mirror);
+    pthread_mutex_destroy(&feed->lock);
+    free(feed);
+}
+
+
+bool feed_keyframe(struct feed *feed)
+{
+    return atomic_exchange(&feed->resync, false);
+}
+
+
+void feed_publish(struct feed *feed, const struct buffer *update)
+{
+    pthread_mutex_lock(&feed->lock);
+    struct buffer *slot = &feed->ring[feed->published % FEED_SLOTS];
+    slot->start = slot->len = 0;
+
+    // update which doesn't fit stays empty, fan-out thread then treats it as lost
+    if (buffer_append(slot, update->data + update->start, update->len - update->start))
+        slot->len = 0;
+    feed->published++;
+    pthread_mutex_unlock(&feed->lock);
+
+    wake(feed);
+}
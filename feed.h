@@ -0,0 +1,96 @@
+// LIBRARY "feed.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef FEED_H
+#define FEED_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "config.h"
+#include "game.h"
+#include "delta.h"
+#include "net.h"
+
+
+/**
+ * Spectator watching the feed.
+ */
+struct viewer {
+    int fd;                     // connection, -1 when the slot is free
+    bool keyframe;              // viewer needs whole state before the next update
+    unsigned long next;         // next update of the history to send
+    struct buffer out;          // message being sent, a viewer never has more than one
+};
+
+
+/**
+ * Read-only spectator feed of a running game.
+ * Game loop only copies its serialized update into a ring & wakes the fan-out thread, it never waits for viewers.
+ * Fan-out thread takes updates out of the ring into its own history & keeps a mirror of the game built from them.
+ * Every viewer follows the history at its own pace, viewer lagging more than FEED_LAG updates behind skips ahead
+ * with a keyframe encoded from the mirror, so slow viewers cost neither the game loop nor the other viewers.
+ */
+struct feed {
+    int fd;                     // listening socket of viewers
+    const char *path;           // path of the socket, removed when feed stops
+    struct message_welcome welcome;     // first message of every viewer
+    int wake[2];                // pipe waking fan-out thread when update is published or feed stops
+    pthread_t thread;           // fan-out thread
+
+    // ring shared by the game loop & fan-out thread, guarded by lock
+    pthread_mutex_t lock;
+    struct buffer ring[FEED_SLOTS];
+    unsigned long published;    // updates published since the start
+    atomic_bool resync;         // fan-out thread lost updates (or hasn't got any yet), keyframe needs to be published
+    atomic_bool quit;           // fan-out thread should exit
+
+    // owned by the fan-out thread only
+    unsigned long taken;        // published updates taken out of the ring
+    struct mirror *mirror;      // game state after the last update of the history
+    struct buffer history[FEED_HISTORY];    // last updates applied to the mirror
+    unsigned long count;        // updates in the history since the start
+    struct buffer keyframe;     // keyframe encoded from the mirror for joining & lagging viewers
+    unsigned long keyframe_at;  // history count of the encoded keyframe
+    struct viewer viewers[MAX_VIEWERS];
+};
+
+
+/**
+ * Starts spectator feed of the game on a UNIX socket & its fan-out thread.
+ * @param path path of the socket
+ * @param game game to be watched, only its settings are read
+ * @returns pointer to the started feed, NULL if socket, thread or memory could not be allocated
+ */
+struct feed *feed_create(const char *path, const struct game *game);
+
+
+/**
+ * Stops fan-out thread, disconnects every viewer & frees the feed.
+ * @param feed feed to free (NULL is allowed)
+ */
+void feed_destroy(struct feed *feed);
+
+
+/**
+ * Tells whether the next published update needs to be a keyframe, the request is consumed.
+ * Keyframe is needed for the first update & whenever the fan-out thread fell more than FEED_SLOTS updates behind.
+ * @param feed spectator feed
+ * @returns true if keyframe needs to be published, false if delta is enough
+ */
+bool feed_keyframe(struct feed *feed);
+
+
+/**
+ * Publishes serialized update (MESSAGE_KEYFRAME or MESSAGE_DELTA) of the current tick.
+ * Update is copied into the ring, overwriting the oldest one, & fan-out thread is woken up.
+ * @attention every tick needs to be published, so that deltas follow each other
+ * @param feed spectator feed
+ * @param update buffer holding the whole message
+ */
+void feed_publish(struct feed *feed, const struct buffer *update);
+
+
+#endif
@@ -0,0 +1,155 @@
+// IMPLEMENTATION of library "frame.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "frame.h"
+
+#include <stdlib.h>
+#include <curses.h>
+
+#define CELL(ch, color_pair) (((color_pair) << 8) | (unsigned char)(ch))
+#define CELL_CHAR(cell) ((cell) & 0xFF)
+#define CELL_COLOR(cell) ((cell) >> 8)
+
+
+// (re)allocates buffers for given screen size
+static int frame_alloc(struct frame *frame, const int lines, const int cols)
+{
+    int *cells = malloc((size_t)lines * cols * sizeof(int));
+    int *shown = malloc((size_t)lines * cols * sizeof(int));
+    if (cells == NULL || shown == NULL) {
+        free(cells);
+        free(shown);
+        return 1;
+    }
+
+    free(frame->cells);
+    free(frame->shown);
+    frame->cells = cells;
+    frame->shown = shown;
+    frame->lines = lines;
+    frame->cols = cols;
+    frame->valid = false;
+    return 0;
+}
+
+
+struct frame *frame_create(void)
+{
+    struct frame *frame = calloc(1, sizeof(struct frame));
+    if (frame == NULL)
+        return NULL;
+
+    if (frame_alloc(frame, LINES, COLS)) {
+        free(frame);
+        return NULL;
+    }
+
+    return frame;
+}
+
+
+void frame_destroy(struct frame *frame)
+{
+    if (frame == NULL)
+        return;
+
+    free(frame->cells);
+    free(frame->shown);
+    free(frame);
+}
+
+
+int frame_begin(struct frame *frame, const int color_pair)
+{
+    if ((LINES != frame->lines || COLS != frame->cols) && frame_alloc(frame, LINES, COLS))
+        return 1;
+
+    int blank = CELL(' ', color_pair);
+    for (long i=0; i < (long)frame->lines * frame->cols; i++)
+        frame->cells[i] = blank;
+
+    return 0;
+}
+
+
+void frame_invalidate(struct frame *frame)
+{
+    frame->valid = false;
+}
+
+
+void frame_put(struct frame *frame, const int row, const int col, const char ch, const int color_pair)
+{
+    if (row < 0 || row >= frame->lines || col < 0 || col >= frame->cols)
+        return;
+
+    frame->cells[row * frame->cols + col] = CELL(ch, color_pair);
+}
+
+
+void frame_span(struct frame *frame, const int row, const int col1, const int col2, const char ch, const int color_pair)
+{
+    if (row < 0 || row >= frame->lines)
+        return;
+
+    int from = col1 < 0 ? 0 : col1;
+    int to = col2 >= frame->cols ? frame->cols-1 : col2;
+    int *cells = frame->cells + row * frame->cols;
+    int cell = CELL(ch, color_pair);
+
+    for (int i=from; i <= to; i++)
+        cells[i] = cell;
+}
+
+
+void frame_text(struct frame *frame, const int row, const int col, const char *text, const int color_pair)
+{
+    for (int i=0; text[i] != '\0'; i++)
+        frame_put(frame, row, col + i, text[i], color_pair);
+}
+
+
+void frame_flush(struct frame *frame)
+{
+    // whole screen is redrawn only when its content is unknown, otherwise just the damaged cells
+    if (!frame->valid)
+        touchwin(stdscr);
+
+    char line[frame->cols];
+    int color = -1;     // color pair currently set in curses
+
+    for (int i=0; i < frame->lines; i++) {
+        int *cells = frame->cells + i * frame->cols;
+        int *shown = frame->shown + i * frame->cols;
+
+        for (int ii=0; ii < frame->cols; ii++) {
+            if (frame->valid && cells[ii] == shown[ii])
+                continue;
+
+            // run of same colored cells, unchanged cells in the middle are sent too (curses skips them anyway)
+            int run_color = CELL_COLOR(cells[ii]);
+            int end = ii;
+            for (int k=ii; k < frame->cols && CELL_COLOR(cells[k]) == run_color; k++) {
+                line[k] = CELL_CHAR(cells[k]);
+                if (!frame->valid || cells[k] != shown[k])
+                    end = k;
+                shown[k] = cells[k];
+            }
+
+            if (run_color != color) {
+                attrset(COLOR_PAIR(run_color));
+                color = run_color;
+            }
+            mvaddnstr(i, ii, line + ii, end - ii + 1);
+
+            ii = end;
+        }
+    }
+    attrset(A_NORMAL);
+
+    frame->valid = true;
+
+    // IMPORTANT TO CALL CURSES' REFRESH FOR UPDATES
+    refresh();
+}
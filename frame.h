@@ -0,0 +1,94 @@
+// LIBRARY "frame.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdbool.h>
+
+
+/**
+ * Off-screen buffer of the whole terminal screen.
+ * Every cell holds its character & color pair. Frame is composed in memory first,
+ * then only cells which differ from the previously displayed frame are sent to curses.
+ */
+struct frame {
+    int lines;          // number of rows of the screen
+    int cols;           // number of columns of the screen
+    int *cells;         // composed frame, (color_pair << 8) | character per cell
+    int *shown;         // frame currently displayed on the screen
+    bool valid;         // false when screen content doesn't match shown frame (first frame, menus, resize)
+};
+
+
+/**
+ * Allocates frame matching the current screen size.
+ * @attention curses screen needs to be initialized
+ * @returns pointer to the allocated frame, NULL if memory could not be allocated
+ */
+struct frame *frame_create(void);
+
+
+/**
+ * Frees frame.
+ * @param frame frame to free (NULL is allowed)
+ */
+void frame_destroy(struct frame *frame);
+
+
+/**
+ * Starts composing new frame, every cell is filled with given color pair.
+ * Frame is resized & invalidated when the screen size changed.
+ * @param color_pair color pair of the background
+ * @returns 0 if everything ok, 1 if memory could not be allocated
+ */
+int frame_begin(struct frame *frame, const int color_pair);
+
+
+/**
+ * Forces the next frame to be fully redrawn (e.g. after menu was displayed over the screen).
+ */
+void frame_invalidate(struct frame *frame);
+
+
+/**
+ * Puts single character into composed frame, positions outside the screen are ignored.
+ * @param row 'y' coordinate on the screen
+ * @param col 'x' coordinate on the screen
+ * @param ch character to display
+ * @param color_pair number of color pair to use
+ */
+void frame_put(struct frame *frame, const int row, const int col, const char ch, const int color_pair);
+
+
+/**
+ * Fills horizontal span of composed frame with a character, part outside the screen is ignored.
+ * @param row 'y' coordinate on the screen
+ * @param col1 'x' coordinate of the first cell of the span
+ * @param col2 'x' coordinate of the last cell of the span (included)
+ * @param ch character to display
+ * @param color_pair number of color pair to use
+ */
+void frame_span(struct frame *frame, const int row, const int col1, const int col2, const char ch, const int color_pair);
+
+
+/**
+ * Puts text into composed frame, characters outside the screen are ignored.
+ * @param row 'y' coordinate on the screen
+ * @param col 'x' coordinate of the first character on the screen
+ * @param text text terminated with '\0'
+ * @param color_pair number of color pair to use
+ */
+void frame_text(struct frame *frame, const int row, const int col, const char *text, const int color_pair);
+
+
+/**
+ * Sends changed cells of composed frame to the screen & refreshes it.
+ * Consecutive cells of the same color are sent as one run, so curses is called once per run instead of once per cell.
+ * @attention color pairs need to be initialized beforehand
+ */
+void frame_flush(struct frame *frame);
+
+
+#endif
@@ -0,0 +1,915 @@
+// IMPLEMENTATION of library "game.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "game.h"
+#include "stencil.h"
+#include "snapshot.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+
+float get_radius(const int size)
+{
+    return size / SIZE_MODIFIER + RADIUS_MODIFIER;
+}
+
+
+bool check_collision(const int row, const int col, const int radius, const struct world *world)
+{
+    // here it is enough to do box-check, no need for circle-check
+    return world_box_empty(world, row-radius, col-radius, row+radius, col+radius);
+}
+
+
+float entity_spawn(int *row, int *col, const struct world *world, struct rng *rng)
+{
+    int size = world->size;
+
+    // random spawn size
+    int radius = rng_int(rng, MIN_BASE_RADIUS, MAX_BASE_RADIUS);
+    if (radius+1 > (size-1)-radius-1) return 0;     // radius can't be bigger than world size
+
+    // try to generate TRIES number of times, then return 0 and don't spawn -> lots of collisions, world probably full
+    int r, c;
+    for (int i=0; i < TRIES; i++) {
+        r = rng_int(rng, radius+RADIUS_MODIFIER*2, (size-1)-radius-RADIUS_MODIFIER*2); // don't spawn very close to edge
+        c = rng_int(rng, radius+RADIUS_MODIFIER*2, (size-1)-radius-RADIUS_MODIFIER*2); // don't spawn very close to edge
+
+        if (check_collision(r, c, radius, world)) {
+            *row = r;
+            *col = c;
+            return radius;
+        }
+    }
+    return 0;
+}
+
+
+int blob_spawn(const int blobs, const int max_blobs, const int count, struct world *world, struct rng *rng, struct events *events)
+{
+    int size = world->size;
+    int spawned = 0;
+
+    // every blob is placed on a free cell drawn from free counts, so crowded worlds don't waste tries on occupied cells
+    for (int i=0; i < count && blobs + spawned < max_blobs; i++) {
+        for (int t=0; t < BLOB_TRIES && world->free_total > 0; t++) {
+            int row, col;
+            world_free_cell(world, rng_bounded64(rng, world->free_total), &row, &col);
+
+            if (row < 1 || row > (size-1)-1 || col < 1 || col > (size-1)-1)
+                continue;
+
+            if (check_collision(row, col, BLOB_RADIUS+1, world)) {
+                world_set(world, row, col, rng_int(rng, ENTITY_COLORS_START, ENTITY_COLORS_END));
+                events_push(events, EVENT_BLOB_SPAWN, -1, -1, row, col);
+                spawned++;
+                break;
+            }
+        }
+    }
+
+    return spawned;
+}
+
+
+// vector of the given length pointing from one position to another (0 when they are aligned)
+static inline int direction(const int from, const int to, const int modifier)
+{
+    return from < to ? modifier : from > to ? -modifier : 0;
+}
+
+
+// decides direction of a single bot according to its surroundings
+static void decide(struct entities *ent, const int i, const struct spatial *spatial, const struct world *world, const float difficulty, struct rng *rng)
+{
+    int row = ent->row[i];
+    int col = ent->col[i];
+    float radius = get_radius(ent->size[i]);
+
+    // nearest entity of different size decides: bigger one is a threat to run away from, smaller one is a prey to chase
+    int near[BOT_NEIGHBOURS];
+    int found = spatial_nearest(spatial, row, col, radius + BOT_VISION, BOT_NEIGHBOURS, near);
+
+    for (int k=0; k < found; k++) {
+        int other = near[k];
+        float other_radius = get_radius(ent->size[other]);
+        if (other == i || other_radius == radius)
+            continue;
+
+        // calculate whether bot should chase or run away, it makes a wrong decision more often on lower difficulty
+        int chase = radius > other_radius ? 1 : -1;
+        int outcome = difficulty * 100 > rng_int(rng, 0, 100) ? chase : chase * -1;
+
+        ent->row_vector[i] = outcome * direction(row, ent->row[other], VERTICAL_MODIFIER);
+        ent->col_vector[i] = outcome * direction(col, ent->col[other], HORIZONTAL_MODIFIER);
+        return;
+    }
+
+    // nothing to chase or run away from, head to the nearest blob
+    int blob_row, blob_col;
+    if (world_nearest_blob(world, row, col, radius + BOT_BLOB_VISION, &blob_row, &blob_col) && difficulty * 100 > rng_int(rng, 0, 100)) {
+        ent->row_vector[i] = direction(row, blob_row, VERTICAL_MODIFIER);
+        ent->col_vector[i] = direction(col, blob_col, HORIZONTAL_MODIFIER);
+        return;
+    }
+
+    // nothing in sight - wander randomly
+    ent->row_vector[i] = rng_int(rng, -VERTICAL_MODIFIER, VERTICAL_MODIFIER);
+    ent->col_vector[i] = rng_int(rng, -HORIZONTAL_MODIFIER, HORIZONTAL_MODIFIER);
+}
+
+
+void update_bot_vectors(struct entities *ent, struct bot_ai *ai, const struct spatial *spatial, const struct world *world, const float difficulty, struct rng *rng)
+{
+    int bots = ent->n - PLAYERS;
+    if (bots <= 0)
+        return;
+
+    // decision budget of this tick, harder bots decide more often
+    float decisions = BOT_MIN_DECISIONS + difficulty * (BOT_MAX_DECISIONS - BOT_MIN_DECISIONS);
+    ai->credit += (float) bots * decisions / VECTOR_UPDATE_RATE;
+    int batch = ai->credit;
+    ai->credit -= batch;
+    if (batch > bots)
+        batch = bots;
+
+    // batch of bots deciding this tick starts at the cursor & wraps around the entity indexes
+    int first = ai->cursor;
+    ai->cursor = PLAYERS + (first - PLAYERS + batch) % bots;
+
+    for (int b=0; b < batch; b++) {
+        int i = PLAYERS + (first - PLAYERS + b) % bots;
+        if (ent->alive[i] && (ai->steered == NULL || !ai->steered[i]))
+            decide(ent, i, spatial, world, difficulty, rng);
+    }
+}
+
+
+int update_positions(struct entities *ent, struct world *world, struct spatial *spatial)
+{
+    int size = world->size;
+    int covered = 0;
+
+    // iterate living entities
+    for (int k = 0; k < ent->live_count; k++) {
+        int i = ent->live[k];
+
+        // border checking
+        int radius = get_radius(ent->size[i]);
+        int new_row = ent->row[i] + ent->row_vector[i];
+        int new_col = ent->col[i] + ent->col_vector[i];
+
+        // need to split these condtitions because of custom move speed modifiers
+        if (new_row - radius < 0)
+            new_row = radius;
+        else if (new_row + radius >= size)
+            new_row = (size-1)-radius;
+        
+        if (new_col - radius < 0)
+            new_col = radius;
+        else if (new_col + radius >= size)
+            new_col = (size-1)-radius;
+
+        // entity bigger than the whole world stays in its centre
+        if (2*radius >= size) {
+            new_row = size/2;
+            new_col = size/2;
+        }
+
+        // update entity in world, new cell is written first so that a lone entity doesn't free its chunk
+        // only to allocate it again in the next call
+        int cell = world_get(world, new_row, new_col);
+        covered += cell >= BLOB_START && cell < ENTITY_START;
+        world_set(world, new_row, new_col, ENTITY_START + i);
+        if (new_row != ent->row[i] || new_col != ent->col[i])
+            world_set(world, ent->row[i], ent->col[i], EMPTY);
+        spatial_move(spatial, i, new_row, new_col);
+
+        // update ent in entities registry
+        ent->row[i] = new_row;
+        ent->col[i] = new_col;   
+    }
+
+    return covered;
+}
+
+
+// picks up blob at the given cell, if there still is one
+static inline void eat_blob(struct entities *ent, struct world *world, const int k, const int i, const int ii, struct events *events)
+{
+    int cell = world_get(world, i, ii);
+
+    if (cell >= BLOB_START && cell < ENTITY_START) {
+        ent->size[k] += 1;
+        world_set(world, i, ii, EMPTY);
+        events_push(events, EVENT_BLOB_EATEN, k, -1, i, ii);
+    }
+}
+
+
+// eliminates smaller entities from the given list (sorted nearest first)
+// if radius and thus size of current entity is bigger, eliminate given entity
+// if the 2 radii are equal, nothing happens
+static void eat_entities(struct entities *ent, struct world *world, struct spatial *spatial, const int k, const int found, const int near[found], struct events *events)
+{
+    for (int i=0; i < found; i++) {
+        int other = near[i];
+        if (other == k || ent->alive[other] == false)
+            continue;
+
+        if (get_radius(ent->size[k]) > get_radius(ent->size[other])) {
+            ent->alive[other] = false;
+            ent->size[k] += ent->size[other] * GROW_MODIFIER;
+            spatial_remove(spatial, other);
+
+            if (world_get(world, ent->row[other], ent->col[other]) == ENTITY_START + other)
+                world_set(world, ent->row[other], ent->col[other], EMPTY);
+            events_push(events, EVENT_KILL, k, other, ent->row[other], ent->col[other]);
+        }
+    }
+}
+
+
+void eval_positions(struct entities *ent, struct world *world, struct spatial *spatial, struct events *events, int near[])
+{
+    // iterate living entities, those eliminated during this evaluation are skipped & compacted out at the end
+    for (int e=0; e < ent->live_count; e++) {
+        int k = ent->live[e];
+        if (ent->alive[k] == false)
+            continue;
+
+        int row = ent->row[k];
+        int col = ent->col[k];
+        float radius = get_radius(ent->size[k]);
+
+        // blob collision evalutation algorithm: iterate & evaluate every index along the circle's circumference
+        // circumference is thickened by the bigger movement modifier to prevent jumping over the hitbox
+        const struct stencil *stencil = stencil_get(radius);
+        for (int s=0; stencil != NULL && s < stencil->ring_count; s++) {
+            int i = row + stencil->ring_row[s];
+            int ii = col + stencil->ring_col[s];
+            if (i < 0 || i >= world->size || ii < 0 || ii >= world->size)
+                continue;   // only entity bigger than the world reaches out of bounds
+
+            eat_blob(ent, world, k, i, ii, events);
+        }
+
+        // entity collision evaluation: every entity with centre inside current entity's circle, nearest first
+        int found = spatial_nearest(spatial, row, col, radius, ent->live_count, near);
+        eat_entities(ent, world, spatial, k, found, near, events);
+    }
+
+    entities_compact(ent);
+}
+
+
+// growable list of candidates gathered by one worker
+struct candidates {
+    int *items;
+    int len;
+    int cap;
+};
+
+
+/**
+ * Scratch of parallel evaluation, allocated once per game.
+ * Worker gathering candidates of entity k is stored in worker[k], its candidates are
+ * ring[worker[k]].items[ring_start[k] .. +ring_count[k]] & near[worker[k]].items[near_start[k] .. +near_count[k]].
+ */
+struct gather {
+    int n;
+    const struct stencil **stencil;     // stencil of every live entity, looked up before workers start
+    int *worker;
+    int *ring_start;
+    int *ring_count;
+    int *near_start;
+    int *near_count;
+
+    int threads;
+    struct candidates *ring;            // ring indexes of cells holding a blob, one list per worker
+    struct candidates *near;            // nearest entities, one list per worker
+
+    // live entities sorted by tile, entities of tile t are tile_list[tile_start[t] .. tile_start[t+1]]
+    int tiles;                          // tiles in one row of the world
+    int *tile_start;
+    int *tile_list;
+
+    // state of the current job
+    const struct entities *ent;
+    const struct world *world;
+    const struct spatial *spatial;
+    atomic_int next_tile;
+    atomic_int gathered;                // entities gathered by all workers
+    atomic_bool failed;                 // some worker ran out of memory
+};
+
+
+static bool reserve(struct candidates *list, const int extra)
+{
+    if (list->len + extra <= list->cap)
+        return true;
+
+    int cap = list->cap > 0 ? list->cap : 256;
+    while (cap < list->len + extra)
+        cap *= 2;
+
+    int *items = realloc(list->items, cap * sizeof(int));
+    if (items == NULL)
+        return false;
+
+    list->items = items;
+    list->cap = cap;
+    return true;
+}
+
+
+// gathers candidates of a single entity, reads world & spatial index only
+static bool gather_entity(struct gather *g, const int worker, const int k)
+{
+    const struct entities *ent = g->ent;
+    const struct world *world = g->world;
+    struct candidates *ring = &g->ring[worker];
+    struct candidates *near = &g->near[worker];
+
+    int row = ent->row[k];
+    int col = ent->col[k];
+    float radius = get_radius(ent->size[k]);
+
+    const struct stencil *stencil = g->stencil[k];
+    g->worker[k] = worker;
+    g->ring_start[k] = ring->len;
+    for (int s=0; stencil != NULL && s < stencil->ring_count; s++) {
+        int i = row + stencil->ring_row[s];
+        int ii = col + stencil->ring_col[s];
+        if (i < 0 || i >= world->size || ii < 0 || ii >= world->size)
+            continue;
+
+        int cell = world_get(world, i, ii);
+        if (cell >= BLOB_START && cell < ENTITY_START) {
+            if (!reserve(ring, 1))
+                return false;
+            ring->items[ring->len++] = s;
+        }
+    }
+    g->ring_count[k] = ring->len - g->ring_start[k];
+
+    if (!reserve(near, ent->live_count))
+        return false;
+    g->near_start[k] = near->len;
+    g->near_count[k] = spatial_nearest(g->spatial, row, col, radius, ent->live_count, near->items + near->len);
+    near->len += g->near_count[k];
+
+    return true;
+}
+
+
+// worker of parallel evaluation, takes tiles one by one until there are none left
+static void gather_job(void *arg, const int worker)
+{
+    struct gather *g = arg;
+    int gathered = 0;
+
+    g->ring[worker].len = 0;
+    g->near[worker].len = 0;
+
+    for (int t = atomic_fetch_add(&g->next_tile, 1); t < g->tiles * g->tiles; t = atomic_fetch_add(&g->next_tile, 1))
+        for (int i = g->tile_start[t]; i < g->tile_start[t+1]; i++) {
+            if (atomic_load_explicit(&g->failed, memory_order_relaxed) || !gather_entity(g, worker, g->tile_list[i])) {
+                atomic_store(&g->failed, true);
+                return;
+            }
+            gathered++;
+        }
+
+    atomic_fetch_add(&g->gathered, gathered);
+}
+
+
+// sorts live entities into tiles (counting sort), tiles of neighbouring entities are processed by the same worker
+static void sort_tiles(struct gather *g, const struct entities *ent, const int world_size)
+{
+    int side = (world_size + g->tiles - 1) / g->tiles;
+    int *start = g->tile_start;
+
+    memset(start, 0, (g->tiles * g->tiles + 1) * sizeof(int));
+    for (int e=0; e < ent->live_count; e++) {
+        int k = ent->live[e];
+        start[(ent->row[k] / side) * g->tiles + ent->col[k] / side + 1]++;
+    }
+    for (int t=0; t < g->tiles * g->tiles; t++)
+        start[t+1] += start[t];
+
+    // start of every tile is used as its insertion cursor, after that it points to the start of the next tile
+    for (int e=0; e < ent->live_count; e++) {
+        int k = ent->live[e];
+        g->tile_list[start[(ent->row[k] / side) * g->tiles + ent->col[k] / side]++] = k;
+    }
+    memmove(start + 1, start, g->tiles * g->tiles * sizeof(int));
+    start[0] = 0;
+}
+
+
+static void gather_destroy(struct gather *g)
+{
+    if (g == NULL)
+        return;
+
+    for (int i=0; g->ring != NULL && i < g->threads; i++)
+        free(g->ring[i].items);
+    for (int i=0; g->near != NULL && i < g->threads; i++)
+        free(g->near[i].items);
+
+    free(g->stencil);
+    free(g->worker);
+    free(g->ring_start);
+    free(g->ring_count);
+    free(g->near_start);
+    free(g->near_count);
+    free(g->ring);
+    free(g->near);
+    free(g->tile_start);
+    free(g->tile_list);
+    free(g);
+}
+
+
+static struct gather *gather_create(const int n, const int world_size, const int threads)
+{
+    struct gather *g = calloc(1, sizeof(struct gather));
+    if (g == NULL)
+        return NULL;
+
+    g->n = n;
+    g->threads = threads;
+    g->stencil = calloc(n, sizeof(struct stencil *));
+    g->worker = calloc(n, sizeof(int));
+    g->ring_start = calloc(n, sizeof(int));
+    g->ring_count = calloc(n, sizeof(int));
+    g->near_start = calloc(n, sizeof(int));
+    g->near_count = calloc(n, sizeof(int));
+    g->ring = calloc(threads, sizeof(struct candidates));
+    g->near = calloc(threads, sizeof(struct candidates));
+
+    // enough tiles to balance the load between workers, but not more than spatial buckets
+    g->tiles = 1;
+    while (g->tiles * g->tiles < threads * PARALLEL_TILES && g->tiles < world_size / SPATIAL_CELL)
+        g->tiles++;
+    g->tile_start = calloc(g->tiles * g->tiles + 1, sizeof(int));
+    g->tile_list = calloc(n, sizeof(int));
+
+    if (g->stencil == NULL || g->worker == NULL || g->ring_start == NULL || g->ring_count == NULL
+        || g->near_start == NULL || g->near_count == NULL || g->ring == NULL || g->near == NULL
+        || g->tile_start == NULL || g->tile_list == NULL) {
+        gather_destroy(g);
+        return NULL;
+    }
+
+    return g;
+}
+
+
+void eval_positions_parallel(struct entities *ent, struct world *world, struct spatial *spatial, struct events *events, int near[], struct pool *pool, struct gather *g)
+{
+    // waking workers costs more than evaluating a few entities
+    if (ent->live_count < PARALLEL_MIN) {
+        eval_positions(ent, world, spatial, events, near);
+        return;
+    }
+
+    // stencil cache isn't thread-safe, so every stencil is built before workers start
+    for (int e=0; e < ent->live_count; e++) {
+        int k = ent->live[e];
+        g->stencil[k] = stencil_get(get_radius(ent->size[k]));
+    }
+
+    // gather phase: world & spatial index are only read, candidates of every entity are collected in parallel
+    g->ent = ent;
+    g->world = world;
+    g->spatial = spatial;
+    sort_tiles(g, ent, world->size);
+    atomic_store(&g->next_tile, 0);
+    atomic_store(&g->gathered, 0);
+    atomic_store(&g->failed, false);
+    pool_run(pool, gather_job, g);
+
+    if (atomic_load(&g->failed) || atomic_load(&g->gathered) != ent->live_count) {
+        eval_positions(ent, world, spatial, events, near);
+        return;
+    }
+
+    // commit phase: candidates are resolved in the same order as in eval_positions(), so the outcome is identical
+    // blobs & entities only disappear during evaluation, therefore candidates are rechecked instead of searched again
+    for (int e=0; e < ent->live_count; e++) {
+        int k = ent->live[e];
+        if (ent->alive[k] == false)
+            continue;
+
+        const struct stencil *stencil = g->stencil[k];
+        const int *ring = g->ring[g->worker[k]].items + g->ring_start[k];
+        for (int s=0; s < g->ring_count[k]; s++)
+            eat_blob(ent, world, k, ent->row[k] + stencil->ring_row[ring[s]], ent->col[k] + stencil->ring_col[ring[s]], events);
+
+        eat_entities(ent, world, spatial, k, g->near_count[k], g->near[g->worker[k]].items + g->near_start[k], events);
+    }
+
+    entities_compact(ent);
+}
+
+
+struct game *game_create(const int world_size, const int max_bots, const uint64_t seed)
+{
+    struct game *game = calloc(1, sizeof(struct game));
+    if (game == NULL)
+        return NULL;
+
+    game->world = world_create(world_size);
+    game->spatial = spatial_create(world_size, max_bots+PLAYERS);
+    game->ent = entities_create(max_bots+PLAYERS);
+    game->blobs_max = world_size / BLOB_MAX_RATIO + 1;
+
+    // spawn grid never has more cells than the smallest square grid holding every entity
+    int grid = 1;
+    while (grid * grid < max_bots+PLAYERS)
+        grid++;
+    game->spawn = malloc(grid * grid * sizeof(int));
+    game->near = malloc((max_bots+PLAYERS) * sizeof(int));
+
+    // the most events happen on reset (every entity & blob spawns) or in a tick when everything is eaten
+    game->events = events_create(2 * (max_bots+PLAYERS) + 2 * game->blobs_max + 1);
+    if (game->world == NULL || game->spatial == NULL || game->ent == NULL || game->events == NULL || game->spawn == NULL
+        || game->near == NULL) {
+        game_destroy(game);
+        return NULL;
+    }
+
+    game->seed = seed;
+    rng_seed(&game->rng, seed);
+    game->difficulty = BOT_HARD;
+    return game;
+}
+
+
+void game_destroy(struct game *game)
+{
+    if (game == NULL)
+        return;
+
+    profile_destroy(game->profile);
+    pool_destroy(game->pool);
+    gather_destroy(game->gather);
+    events_destroy(game->events);
+    entities_destroy(game->ent);
+    spatial_destroy(game->spatial);
+    world_destroy(game->world);
+    free(game->spawn);
+    free(game->near);
+    free(game);
+}
+
+
+int game_threads(struct game *game, const int threads)
+{
+    pool_destroy(game->pool);
+    gather_destroy(game->gather);
+    game->pool = NULL;
+    game->gather = NULL;
+
+    if (threads <= 1)
+        return 0;
+
+    game->pool = pool_create(threads);
+    game->gather = gather_create(game->ent->n, game->world->size, threads);
+    if (game->pool == NULL || game->gather == NULL) {
+        pool_destroy(game->pool);
+        gather_destroy(game->gather);
+        game->pool = NULL;
+        game->gather = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+
+// jittered grid of world generation, every placed entity gets its own grid cell (see game_reset())
+struct layout {
+    struct entities *ent;
+    const int *cells;           // grid cell of every placed entity
+    int placed;                 // entities having a grid cell
+    int grid;                   // grid cells in one row
+    int side;                   // side of a grid cell
+    int max_radius;             // the biggest radius fitting inside a grid cell
+    uint64_t seed;              // every entity is placed by its own generator derived from this seed
+    atomic_int next;            // first entity of the next chunk
+};
+
+
+// entity is placed somewhere inside its grid cell, its box never reaches the last row & col of the cell,
+// so boxes of entities in neighbouring cells don't touch
+static void place_entity(const struct layout *l, const int i)
+{
+    struct entities *ent = l->ent;
+    struct rng rng;
+    rng_seed(&rng, l->seed + i);
+
+    int radius = rng_int(&rng, MIN_BASE_RADIUS, l->max_radius);
+    int top = 1 + (l->cells[i] / l->grid) * l->side;
+    int left = 1 + (l->cells[i] % l->grid) * l->side;
+
+    ent->row[i] = rng_int(&rng, top + radius, top + l->side-2 - radius);
+    ent->col[i] = rng_int(&rng, left + radius, left + l->side-2 - radius);
+    ent->row_vector[i] = 0;
+    ent->col_vector[i] = 0;
+    ent->size[i] = radius * SIZE_MODIFIER;
+    ent->color[i] = rng_int(&rng, ENTITY_COLORS_START, ENTITY_COLORS_END);
+}
+
+
+static void layout_job(void *arg, const int worker)
+{
+    (void) worker;
+    struct layout *l = arg;
+
+    for (int first = atomic_fetch_add(&l->next, SPAWN_CHUNK); first < l->placed; first = atomic_fetch_add(&l->next, SPAWN_CHUNK))
+        for (int i=first; i < first + SPAWN_CHUNK && i < l->placed; i++)
+            place_entity(l, i);
+}
+
+
+void game_reset(struct game *game)
+{
+    struct entities *ent = game->ent;
+
+    // init world
+    world_reset(game->world, game->world->size, game->pool);
+    spatial_clear(game->spatial);
+    entities_clear(ent);
+    game->ticks = 0;
+    game->ai.cursor = PLAYERS;
+    game->ai.credit = 0;
+
+    // counters are rebuilt from spawn events
+    events_clear(game->events);
+    game->alive = 0;
+    game->blobs = 0;
+    game->kills = 0;
+    game->blobs_eaten = 0;
+
+    // init entities
+    // jittered grid - the smallest square grid with a cell for every entity, cells shrink down to the smallest entity
+    int inner = game->world->size - 2;
+    int grid = 1;
+    while (grid * grid < ent->n)
+        grid++;
+    int side = inner / grid;
+    if (side < 2*MIN_BASE_RADIUS + 2) {
+        side = 2*MIN_BASE_RADIUS + 2;
+        grid = inner / side;
+    }
+
+    // random grid cell for every entity (partial Fisher-Yates shuffle)
+    int cells = grid * grid;
+    for (int c=0; c < cells; c++)
+        game->spawn[c] = c;
+
+    struct layout layout = {
+        .ent = ent, .cells = game->spawn, .placed = ent->n < cells ? ent->n : cells, .grid = grid, .side = side,
+        .max_radius = (side-2) / 2 < MAX_BASE_RADIUS ? (side-2) / 2 : MAX_BASE_RADIUS, .seed = rng_next(&game->rng)
+    };
+    for (int i=0; i < layout.placed; i++) {
+        int j = i + rng_bounded(&game->rng, cells - i);
+        int tmp = game->spawn[i];
+        game->spawn[i] = game->spawn[j];
+        game->spawn[j] = tmp;
+    }
+
+    // entities are placed independently of each other, so any number of workers places them the same way
+    atomic_init(&layout.next, 0);
+    if (game->pool != NULL)
+        pool_run(game->pool, layout_job, &layout);
+    else
+        layout_job(&layout, 0);
+
+    // entities without a grid cell (world is too small for all of them) try random positions instead,
+    // the grid is already full, so most of them don't find a free place & start eliminated
+    for (int i=0; i < ent->n; i++) {
+        if (i >= layout.placed) {
+            int ent_row = 0, ent_col = 0;
+            int ent_radius = entity_spawn(&ent_row, &ent_col, game->world, &game->rng);
+
+            ent->row[i] = ent_row;
+            ent->col[i] = ent_col;
+            ent->row_vector[i] = 0;
+            ent->col_vector[i] = 0;
+            ent->size[i] = ent_radius * SIZE_MODIFIER;
+            ent->color[i] = rng_int(&game->rng, ENTITY_COLORS_START, ENTITY_COLORS_END);
+        }
+
+        // add living entity to world marked with its unique index starting from ENTITY START (player is at ENTITY_START)
+        if (ent->size[i] > 0) {
+            entities_add(ent, i);
+            world_set(game->world, ent->row[i], ent->col[i], ENTITY_START + i);
+            spatial_move(game->spatial, i, ent->row[i], ent->col[i]);
+            events_push(game->events, EVENT_SPAWN, i, -1, ent->row[i], ent->col[i]);
+        }
+    }
+
+    // init blobs
+    // spawn more blobs at once in the beggining
+    blob_spawn(game->blobs, game->blobs_max, game->blobs_max-1, game->world, &game->rng, game->events);
+    game_events(game);
+}
+
+
+void game_events(struct game *game)
+{
+    struct events *events = game->events;
+
+    for (; events->applied < events->count; events->applied++) {
+        const struct event *event = &events->queue[events->applied];
+
+        switch (event->type) {
+            case EVENT_SPAWN:
+                game->alive += 1;
+                break;
+
+            case EVENT_BLOB_SPAWN:
+                game->blobs += 1;
+                break;
+
+            case EVENT_BLOB_EATEN:
+                game->blobs -= 1;
+                game->blobs_eaten += 1;
+                break;
+
+            case EVENT_KILL:
+                game->alive -= 1;
+                game->kills += 1;
+                break;
+        }
+    }
+}
+
+
+void game_tick(struct game *game)
+{
+    struct profile *profile = game->profile;
+    events_clear(game->events);
+
+    if (game->ticks % BLOB_UPDATE_RATE == 0)
+        PROFILED(profile, PHASE_BLOB_SPAWN, blob_spawn(game->blobs, game->blobs_max, 1 + game->blobs_max / BLOB_BATCH_RATIO, game->world, &game->rng, game->events));
+
+    PROFILED(profile, PHASE_BOT_VECTORS, update_bot_vectors(game->ent, &game->ai, game->spatial, game->world, game->difficulty, &game->rng));
+
+    // blobs covered by entities disappear without being eaten
+    PROFILED(profile, PHASE_POSITIONS, game->blobs -= update_positions(game->ent, game->world, game->spatial));
+    if (game->pool != NULL)
+        PROFILED(profile, PHASE_EVAL, eval_positions_parallel(game->ent, game->world, game->spatial, game->events, game->near, game->pool, game->gather));
+    else
+        PROFILED(profile, PHASE_EVAL, eval_positions(game->ent, game->world, game->spatial, game->events, game->near));
+    game_events(game);
+
+    game->ticks = game->ticks >= ULONG_MAX - 1 ? 0 : game->ticks+1; // update tick & overflow protection
+}
+
+
+bool game_over(const struct game *game)
+{
+    return !game->ent->alive[PLAYER] || game->alive <= PLAYERS;
+}
+
+
+// random player for headless games - changes direction as often as bots do
+static void random_player_vectors(struct entities *ent, struct rng *rng)
+{
+    ent->row_vector[PLAYER] = rng_int(rng, -VERTICAL_MODIFIER, VERTICAL_MODIFIER);
+    ent->col_vector[PLAYER] = rng_int(rng, -HORIZONTAL_MODIFIER, HORIZONTAL_MODIFIER);
+}
+
+
+// prints summary line of a game simulated between start & end
+static void summary(const struct game *game, const unsigned long ticks, const struct timespec *start, const struct timespec *end)
+{
+    double elapsed = (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+
+    printf("seed=%llu ticks=%lu elapsed=%.3f ticks_per_sec=%.1f alive=%d player_alive=%d player_size=%d blobs=%d kills=%lu blobs_eaten=%lu\n",
+        (unsigned long long) game->seed, ticks, elapsed, elapsed > 0 ? ticks / elapsed : 0, game->alive, game->ent->alive[PLAYER], game->ent->size[PLAYER], game->blobs, game->kills, game->blobs_eaten);
+}
+
+
+int game_headless(const struct options *options)
+{
+    struct game *game;
+    if (options->load != NULL && (game = snapshot_load(options->load)) == NULL) {
+        printf("Snapshot %s could not be loaded.\n", options->load);
+        return 1;
+    }
+    if (options->load == NULL)
+        game = game_create(options->world_size, options->bots, options->seed);
+
+    if (game == NULL || (options->profile != NULL && (game->profile = profile_create()) == NULL)) {
+        game_destroy(game);
+        printf("Not enough memory to create the world.\n");
+        return 1;
+    }
+    if (game_threads(game, options->threads)) {
+        game_destroy(game);
+        printf("Threads could not be started.\n");
+        return 1;
+    }
+    if (options->load == NULL)
+        game_reset(game);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    unsigned long tick;
+    for (tick=0; tick < options->ticks && !game_over(game); tick++) {
+        if (game->profile != NULL)
+            profile_tick(game->profile, game->ticks);
+
+        if (game->ticks % VECTOR_UPDATE_RATE == 0)
+            PROFILED(game->profile, PHASE_PLAYER_VECTORS, random_player_vectors(game->ent, &game->rng));
+
+        game_tick(game);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    summary(game, tick, &start, &end);
+
+    if (game->profile != NULL && profile_dump(game->profile, options->profile))
+        printf("Profiler trace could not be written to %s.\n", options->profile);
+    if (options->save != NULL && snapshot_save(game, options->save))
+        printf("Snapshot could not be written to %s.\n", options->save);
+
+    game_destroy(game);
+    stencil_free();
+    return 0;
+}
+
+
+int game_replay(const struct options *options)
+{
+    struct replay *replay = replay_load(options->replay);
+    if (replay == NULL) {
+        printf("Replay %s could not be loaded.\n", options->replay);
+        return 1;
+    }
+
+    struct game *game = game_create(replay->header.world_size, replay->header.bots, replay->header.seed);
+    if (game == NULL || (options->profile != NULL && (game->profile = profile_create()) == NULL)) {
+        game_destroy(game);
+        replay_close(replay);
+        printf("Not enough memory to create the world.\n");
+        return 1;
+    }
+    if (game_threads(game, options->threads)) {
+        game_destroy(game);
+        replay_close(replay);
+        printf("Threads could not be started.\n");
+        return 1;
+    }
+
+    // games are reset in the recorded order, so the random generator continues exactly as it did
+    float difficulty;
+    while (replay_next_game(replay, &difficulty)) {
+        game_reset(game);
+        game->difficulty = difficulty;
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        unsigned long tick;
+        for (tick=0; tick < options->ticks; tick++) {
+            if (game->profile != NULL)
+                profile_tick(game->profile, game->ticks);
+
+            struct entities *ent = game->ent;
+            bool playing;
+            PROFILED(game->profile, PHASE_PLAYER_VECTORS, playing = replay_input(replay, game->ticks, &ent->row_vector[PLAYER], &ent->col_vector[PLAYER]));
+            if (!playing)
+                break;
+
+            game_tick(game);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        summary(game, tick, &start, &end);
+    }
+
+    if (game->profile != NULL && profile_dump(game->profile, options->profile))
+        printf("Profiler trace could not be written to %s.\n", options->profile);
+
+    replay_close(replay);
+    game_destroy(game);
+    stencil_free();
+    return 0;
+}
@@ -0,0 +1,285 @@
+// LIBRARY "game.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "world.h"
+#include "spatial.h"
+#include "entity.h"
+#include "profile.h"
+#include "rng.h"
+#include "pool.h"
+#include "event.h"
+#include "replay.h"
+
+
+/**
+ * Game settings given on the command line.
+ */
+struct options {
+    int world_size;             // dimensions of the generated world
+    int bots;                   // number of bots to generate inside the world
+    bool headless;              // run without terminal
+    unsigned long ticks;        // maximum number of ticks of headless game
+    const char *profile;        // file for profiler trace, NULL when profiling is off
+    uint64_t seed;              // seed of the game's random generator
+    int threads;                // number of threads evaluating collisions
+    const char *record;         // file to record replay into, NULL when recording is off
+    const char *replay;         // replay file to play back instead of a new game, NULL otherwise
+    const char *load;           // snapshot file to continue instead of generating the first game, NULL otherwise
+    const char *save;           // file to save snapshot of finished headless game into, NULL otherwise
+    const char *checkpoint;     // file for periodic checkpoints of interactive game, NULL when checkpoints are off
+    const char *serve;          // socket of the multiplayer server to run, NULL otherwise
+    const char *connect;        // socket of the multiplayer server to join, NULL otherwise
+    const char *spectate;       // socket of spectators of the multiplayer server to run, NULL when spectators aren't allowed
+    const char *watch;          // socket of spectators of the multiplayer server to watch, NULL otherwise
+};
+
+
+// scratch of parallel collision evaluation (see eval_positions_parallel())
+struct gather;
+
+
+/**
+ * Round-robin scheduler of bot decisions.
+ * Every tick only a batch of bots decides, so the cost of bot AI is spread evenly over ticks.
+ */
+struct bot_ai {
+    int cursor;                 // entity index of the first bot deciding in the next tick
+    float credit;               // fraction of a decision carried over to the next tick
+    const bool *steered;        // entities steered by clients of the server are skipped, NULL when there are none
+};
+
+
+/**
+ * Complete state of one game simulation, independent of curses.
+ */
+struct game {
+    struct world *world;        // map of a world containing blobs & entity indexes
+    struct spatial *spatial;    // spatial index of entities
+    struct entities *ent;       // registry of all entities (player & bots)
+
+    // counters maintained from events (see game_events())
+    int blobs;                  // blobs currently in the world, blobs covered by moving entities are subtracted in game_tick()
+    int alive;                  // entities alive (player included)
+    unsigned long kills;        // entities eliminated since the start of the game
+    unsigned long blobs_eaten;  // blobs picked up since the start of the game
+
+    struct events *events;      // events of the current tick
+    int blobs_max;              // maximum amount of blobs existing at the same time
+    float difficulty;           // bot difficulty level
+    struct bot_ai ai;           // scheduler of bot decisions
+    unsigned long ticks;        // game ticks since the start of the game
+
+    uint64_t seed;              // seed the random generator was initialized with
+    struct rng rng;             // random generator of the simulation
+
+    int *spawn;                 // grid cells of the world generation (see game_reset())
+    int *near;                  // nearest entities of one entity during collision evaluation (see eval_positions())
+
+    struct pool *pool;          // threads generating the world & evaluating collisions, NULL when game runs on a single thread
+    struct gather *gather;      // scratch of parallel evaluation, NULL when game runs on a single thread
+
+    struct profile *profile;    // profiler of tick phases, NULL when profiling is off
+};
+
+
+/**
+ *
+ * Calculates radius using the entity's size.
+ * @param size size of entity
+ */
+float get_radius(const int size);
+
+
+/**
+ * Detects other entities & blobs inside the box around the given entity.
+ * Whole box is tested on the occupancy bitmap of the world (see world_box_empty()).
+ * @attention It is implicit that given row & col +- radius inside the world bounds.
+ * @attention This function doesn't take into account possible differences in radius, therefore it is only suitable on world spawn.
+ * @param row 'y' coordinate of entity
+ * @param col 'x' coordinate of entity
+ * @param radius size of entity
+ * @param world map of a world containing entity indexes
+ * @returns true if every cell within given radius is empty, false otherwise
+ */
+bool check_collision(const int row, const int col, const int radius, const struct world *world);
+
+
+/**
+ * Spawns entities on random coordinates in the world.
+ * @implements check_collision() to prevent spawning inside one another.
+ * @param row pointer to store randomly generated row
+ * @param col pointer to store randomly generated col
+ * @param world map of a world containing entity indexes - used for collision detection
+ * @param rng random generator
+ * @returns randomly generated radius of spawned entity after successful generation, 0 otherwise
+ */
+float entity_spawn(int *row, int *col, const struct world *world, struct rng *rng);
+
+
+/**
+ * Spawns batch of blobs on random free cells of the world.
+ * Free cells are drawn uniformly using free counts of world chunks, so work per blob is bounded even in a crowded world.
+ * Functions prevents spawning blob next to another blob, each blob gets BLOB_TRIES free cells to try.
+ * @param blobs amount of blobs already spawned
+ * @param max_blobs maximum amount of blobs allowed to be spawned at the same time
+ * @param count number of blobs to spawn
+ * @param world map of a world
+ * @param rng random generator
+ * @param events queue for EVENT_BLOB_SPAWN of every spawned blob
+ * @returns number of spawned blobs
+*/
+int blob_spawn(const int blobs, const int max_blobs, const int count, struct world *world, struct rng *rng, struct events *events);
+
+
+/**
+ * Bot vectors calculated according to surroundings of every bot.
+ * Bot looks at BOT_NEIGHBOURS nearest entities within its vision (spatial query), the nearest one of different size decides:
+ * smaller one is chased, bigger one is avoided. When there is none, bot heads to the nearest blob or wanders randomly.
+ * Called every tick, only the next batch of bots (round-robin) decides. Every bot decides
+ * BOT_MIN_DECISIONS to BOT_MAX_DECISIONS times per VECTOR_UPDATE_RATE ticks, depending on difficulty.
+ * Bots steered by clients of the server (see ai->steered) keep their direction.
+ * @attention To make game more interesting some degree of randomness is integrated in calculations.
+ * @param ent registry of all entities (player & bots)
+ * @param ai scheduler of bot decisions
+ * @param spatial spatial index of entities - used to find entities near the bot
+ * @param world map of a world - used to find blobs near the bot
+ * @param difficulty bot difficulty level
+ * @param rng random generator
+ */
+void update_bot_vectors(struct entities *ent, struct bot_ai *ai, const struct spatial *spatial, const struct world *world, const float difficulty, struct rng *rng);
+
+
+/**
+ * Updates positions of entities in both world & entities registry.
+ * Moves entities in direction according to their vectors.
+ * @param ent registry of all entities (player & bots)
+ * @param world map of a world containing entity indexes
+ * @param spatial spatial index of entities, updated incrementally
+ * @returns number of blobs covered by the new cells of entities (they are gone from the world)
+ */
+int update_positions(struct entities *ent, struct world *world, struct spatial *spatial);
+
+
+/**
+ * Performs collision evaluation with other entities & blobs.
+ * Blobs are picked up along the entity's circumference, other entities are found in spatial index.
+ * @param ent registry of all entities (player & bots), eliminated entities are compacted out of its live list
+ * @param world map of a world containing entity indexes
+ * @param spatial spatial index of entities, eliminated entities are removed from it
+ * @param events queue for EVENT_BLOB_EATEN & EVENT_KILL events
+ * @param near scratch for the nearest entities of one entity, at least ent->n long
+ */
+void eval_positions(struct entities *ent, struct world *world, struct spatial *spatial, struct events *events, int near[]);
+
+
+/**
+ * Performs collision evaluation with other entities & blobs on multiple threads.
+ * World is split into tiles of spatial buckets, workers take tiles one by one & gather candidates
+ * (blobs on the circumference, entities inside the circle) while world & spatial index are only read.
+ * Candidates are then resolved on the calling thread in the order of eval_positions(), so the outcome is identical.
+ * @attention falls back to eval_positions() when workers run out of memory
+ * @param ent registry of all entities (player & bots), eliminated entities are compacted out of its live list
+ * @param world map of a world containing entity indexes
+ * @param spatial spatial index of entities, eliminated entities are removed from it
+ * @param events queue for EVENT_BLOB_EATEN & EVENT_KILL events, in the same order as eval_positions() emits them
+ * @param near scratch of eval_positions() when it is fallen back to, at least ent->n long
+ * @param pool threads gathering candidates
+ * @param gather scratch of parallel evaluation (see game_threads())
+ */
+void eval_positions_parallel(struct entities *ent, struct world *world, struct spatial *spatial, struct events *events, int near[], struct pool *pool, struct gather *gather);
+
+
+
+/**
+ * Allocates new game, the world is empty until game_reset() is called.
+ * @param world_size dimensions of the world
+ * @param max_bots number of bots to generate inside the world
+ * @param seed seed of the game's random generator, same seed generates the same games
+ * @returns pointer to the allocated game, NULL if memory could not be allocated
+ */
+struct game *game_create(const int world_size, const int max_bots, const uint64_t seed);
+
+
+/**
+ * Frees game & all of its parts.
+ * @param game game to free (NULL is allowed)
+ */
+void game_destroy(struct game *game);
+
+
+/**
+ * Sets number of threads generating the world & evaluating collisions, game runs on a single thread by default.
+ * Results are the same for any number of threads.
+ * @param game game to update
+ * @param threads number of threads (calling thread included), 1 or less disables parallel evaluation
+ * @returns 0 if everything ok, 1 if threads could not be started (game is left on a single thread)
+ */
+int game_threads(struct game *game, const int threads);
+
+
+/**
+ * Generates new world - clears it, spawns entities & initial blobs.
+ * Entities are placed on a jittered grid: every entity gets its own grid cell & a random position inside it,
+ * so every entity is spawned as long as the grid has a cell for each of them.
+ * Cells can't get smaller than the smallest entity, so a small world holds only ((size-2) / (2*MIN_BASE_RADIUS+2))^2 cells.
+ * Entities left without a cell try TRIES random positions (see entity_spawn()) & stay eliminated when none is free,
+ * so the number of living bots is only best-effort in such worlds.
+ * World is cleared & entities are placed on all threads of the game, the generated world is the same for any number of threads.
+ * Allocations of the previous game are reused.
+ * @param game game to reset
+ */
+void game_reset(struct game *game);
+
+
+/**
+ * Applies events queued since the last call to game counters (alive, blobs, kills, blobs eaten).
+ * @param game game to update
+ */
+void game_events(struct game *game);
+
+
+/**
+ * Performs one game tick: blob spawning, bot vectors, movement & collision evaluation.
+ * Events of the tick stay in game->events until the next tick, counters are already updated from them.
+ * Every phase is measured when game has profiler.
+ * @attention player's vectors need to be updated by the caller (& profile_tick() called before when profiling)
+ * @param game game to update
+ */
+void game_tick(struct game *game);
+
+
+/**
+ * Decides whether the game has ended.
+ * @returns true if player is dead or there are no bots left, false otherwise
+ */
+bool game_over(const struct game *game);
+
+
+/**
+ * Runs game without terminal, player moves randomly & ticks run as fast as possible.
+ * Game is continued from options->load snapshot when given, its state is saved into options->save at the end.
+ * Prints summary of the game to the standard output.
+ * @param options game settings, at most options->ticks are simulated (game ends sooner if it is over)
+ * @returns 0 if everything ok, 1 if game could not be created or loaded
+ */
+int game_headless(const struct options *options);
+
+
+/**
+ * Plays back recorded replay without terminal, ticks run as fast as possible.
+ * Game settings & seed come from the replay, so every recorded game is simulated exactly as it was played.
+ * Prints summary of every game to the standard output.
+ * @param options game settings, at most options->ticks are simulated in every game
+ * @returns 0 if everything ok, 1 if replay could not be loaded or game could not be created
+ */
+int game_replay(const struct options *options);
+
+
+#endif
@@ -1,37 +1,136 @@
 #include "agario.h"
 #include "config.h"
+#include "server.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
+#define USAGE_TEXT "Usage: ./agar.io <WORLD-SIZE> <NUMBER-OF-BOTS> [--headless <TICKS>] [--profile <TRACE-FILE>] [--seed <SEED>] [--threads <THREADS>] [--record <REPLAY-FILE>] [--replay <REPLAY-FILE>] [--load <SNAPSHOT-FILE>] [--save <SNAPSHOT-FILE>] [--checkpoint <SNAPSHOT-FILE>] [--serve <SOCKET>] [--spectate <SOCKET>] [--connect <SOCKET>] [--watch <SOCKET>]\n"
+
 int main(int argc, char *argv[])
 {
-    // init random seed
-    srand(time(NULL));
-
     // command line argument input
-    if (argc != GAME_PARAMETERS+1) {
-        printf("Wrong number of arguments!\nUsage: ./agar.io <WORLD-SIZE> <NUMBER-OF-BOTS>\n");
+    if (argc < GAME_PARAMETERS+1) {
+        printf("Wrong number of arguments!\n" USAGE_TEXT);
         return EXIT_FAILURE;
     }
 
     // parse command line arguments
-    int world_size, bot_count;
-    sscanf(argv[1], "%d", &world_size);
-    sscanf(argv[2], "%d", &bot_count);
+    struct options options = {0};
+    options.seed = time(NULL);      // random game unless seed is given
+    options.threads = 1;
+    sscanf(argv[1], "%d", &options.world_size);
+    sscanf(argv[2], "%d", &options.bots);
+
+    // optional arguments
+    for (int i=GAME_PARAMETERS+1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0 && i+1 < argc) {
+            options.headless = true;
+            sscanf(argv[++i], "%lu", &options.ticks);
+        } else if (strcmp(argv[i], "--profile") == 0 && i+1 < argc) {
+            options.profile = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc) {
+            unsigned long long seed;
+            if (sscanf(argv[++i], "%llu", &seed) != 1) {
+                printf("Incorrect seed %s!\n" USAGE_TEXT, argv[i]);
+                return EXIT_FAILURE;
+            }
+            options.seed = seed;
+        } else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+            sscanf(argv[++i], "%d", &options.threads);
+        } else if (strcmp(argv[i], "--record") == 0 && i+1 < argc) {
+            options.record = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i+1 < argc) {
+            options.replay = argv[++i];
+        } else if (strcmp(argv[i], "--load") == 0 && i+1 < argc) {
+            options.load = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i+1 < argc) {
+            options.save = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i+1 < argc) {
+            options.checkpoint = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i+1 < argc) {
+            options.serve = argv[++i];
+        } else if (strcmp(argv[i], "--spectate") == 0 && i+1 < argc) {
+            options.spectate = argv[++i];
+        } else if (strcmp(argv[i], "--connect") == 0 && i+1 < argc) {
+            options.connect = argv[++i];
+        } else if (strcmp(argv[i], "--watch") == 0 && i+1 < argc) {
+            options.watch = argv[++i];
+        } else {
+            printf("Unknown argument %s!\n" USAGE_TEXT, argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
 
     // input checking
-    if (world_size < MIN_WORLD_SIZE || world_size > MAX_WORLD_SIZE) {
+    if (options.world_size < MIN_WORLD_SIZE || options.world_size > MAX_WORLD_SIZE) {
         printf("Incorrect size of the world. Should be in range %d to %d.\n", MIN_WORLD_SIZE, MAX_WORLD_SIZE);
         return EXIT_FAILURE;
     }
-    if (bot_count < MIN_BOT_COUNT || bot_count > MAX_BOT_COUNT) {
+    if (options.bots < MIN_BOT_COUNT || options.bots > MAX_BOT_COUNT) {
         printf("Incorrect number of bots. Should be in range %d to %d.\n", MIN_BOT_COUNT, MAX_BOT_COUNT);
         return EXIT_FAILURE;
     }
 
-    agario(world_size, bot_count);
+    if (options.threads < 1 || options.threads > MAX_THREADS) {
+        printf("Incorrect number of threads. Should be in range %d to %d.\n", 1, MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    // replay is recorded only by an interactive game, it starts from a generated world, not from a snapshot
+    if (options.record != NULL && (options.headless || options.serve != NULL || options.connect != NULL
+        || options.watch != NULL || options.replay != NULL)) {
+        printf("Replay can be recorded only in an interactive game.\n" USAGE_TEXT);
+        return EXIT_FAILURE;
+    }
+    if (options.record != NULL && options.load != NULL) {
+        printf("Replay can't be recorded from a loaded snapshot.\n" USAGE_TEXT);
+        return EXIT_FAILURE;
+    }
+
+    // snapshots belong to games simulated by this process, a local one is either interactive or headless
+    bool local = options.serve == NULL && options.connect == NULL && options.watch == NULL && options.replay == NULL;
+    if (options.load != NULL && !local) {
+        printf("Snapshot can be loaded only by an interactive or headless game.\n" USAGE_TEXT);
+        return EXIT_FAILURE;
+    }
+    if (options.save != NULL && (!local || !options.headless)) {
+        printf("Snapshot can be saved only at the end of a headless game.\n" USAGE_TEXT);
+        return EXIT_FAILURE;
+    }
+    if (options.checkpoint != NULL && (!local || options.headless)) {
+        printf("Checkpoints can be written only by an interactive game.\n" USAGE_TEXT);
+        return EXIT_FAILURE;
+    }
+
+    // spectators watch a running server
+    if (options.spectate != NULL && options.serve == NULL) {
+        printf("Spectators can be allowed only on a server.\n" USAGE_TEXT);
+        return EXIT_FAILURE;
+    }
+
+    // server runs without terminal, client plays (or only watches) in the world of the server
+    if (options.serve != NULL)
+        return server_run(&options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.connect != NULL || options.watch != NULL) {
+        agario_connect(&options);
+        return EXIT_SUCCESS;
+    }
+
+    // replay is played back with its own world size & number of bots, without terminal when headless
+    if (options.replay != NULL && options.headless)
+        return game_replay(&options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options.replay != NULL) {
+        agario_replay(&options);
+        return EXIT_SUCCESS;
+    }
+
+    if (options.headless)
+        return game_headless(&options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    agario(&options);
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -5,62 +5,121 @@
 #include "name.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 
-int random_line(int *line, int *longest_word)
+/**
+ * Reads whole file into a null terminated buffer.
+ * @param filename file to read
+ * @param length pointer to save number of bytes read
+ * @returns allocated buffer, NULL if the file cannot be read
+ */
+static char *read_file(const char *filename, long *length)
 {
-    FILE *fp = fopen(NAMELIST_FILENAME, "r");
+    FILE *fp = fopen(filename, "rb");
 
     if(fp == NULL)
-        return 1;
+        return NULL;
 
-    int ch;
-    int lc = 1, max_l = 0, l = 0;
+    char *data = NULL;
+    long len = -1;
 
-    // count lines in file
-    while ((ch = getc(fp)) != EOF) {
-        l++;
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) >= 0 && fseek(fp, 0, SEEK_SET) == 0)
+        data = malloc(len + 1);
 
-        if (ch == '\n') {
-            lc++;
-
-            if (l > max_l)
-                max_l = l;
-            
-            l = 0;
-        }
+    if (data != NULL && fread(data, 1, len, fp) != (size_t) len) {
+        free(data);
+        data = NULL;
     }
+    fclose(fp);
 
-    *line = rand() % (lc + 1);
-    *longest_word = max_l + 1;        // +1 for null terminator
+    if (data == NULL)
+        return NULL;
 
-    fclose(fp);
-    return 0;
+    data[len] = '\0';
+    *length = len;
+    return data;
+}
+
+
+// names are separated by any line ending, stray NUL bytes end a name too
+static bool separator(const char ch)
+{
+    return ch == '\n' || ch == '\r' || ch == '\0';
 }
 
 
-int get_line(const int line, const int max_l, char name[])
+struct names *names_load(const char *filename)
 {
-    FILE *fp = fopen(NAMELIST_FILENAME, "r");
+    struct names *names = calloc(1, sizeof(struct names));
+    if (names == NULL)
+        return NULL;
 
-    if(fp == NULL)
-        return 1;
-
-    int ch;
-    int lc = 0;
-    while ((ch = getc(fp)) != EOF) {
-        if (ch == '\n')
-            lc++;
-        
-        if (lc == line) {
-            int line_ch, line_i;
-            for (line_i=0; (line_ch = getc(fp)) != '\n' && line_i < max_l; line_i++)
-                name[line_i] = line_ch;
-
-            name[line_i] = '\0';     // terminate string at the end
-            break;
-        }
+    long len;
+    names->data = read_file(filename, &len);
+    if (names->data == NULL) {
+        names_destroy(names);
+        return NULL;
     }
-    fclose(fp);
-    return 0;
-}
\ No newline at end of file
+
+    // upper bound of name count, so the index is allocated only once
+    int lines = 1;
+    for (long i=0; i < len; i++)
+        if (separator(names->data[i]))
+            lines++;
+
+    names->offsets = malloc(lines * sizeof(int));
+    names->deck = malloc(lines * sizeof(int));
+    if (names->offsets == NULL || names->deck == NULL) {
+        names_destroy(names);
+        return NULL;
+    }
+
+    // terminate every line in place & index non-empty ones
+    long start = 0;
+    for (long i=0; i <= len; i++) {
+        if (!separator(names->data[i]))
+            continue;
+
+        names->data[i] = '\0';
+        if (i > start)
+            names->offsets[names->count++] = start;
+        start = i + 1;
+    }
+
+    for (int i=0; i < names->count; i++)
+        names->deck[i] = i;
+
+    names->remaining = names->count;
+    return names;
+}
+
+
+void names_destroy(struct names *names)
+{
+    if (names == NULL)
+        return;
+
+    free(names->data);
+    free(names->offsets);
+    free(names->deck);
+    free(names);
+}
+
+
+const char *names_random(struct names *names, struct rng *rng)
+{
+    if (names == NULL || names->count == 0)
+        return "";
+
+    if (names->remaining == 0)
+        names->remaining = names->count;
+
+    // one step of Fisher-Yates shuffle, drawn names are moved to the end of the deck
+    int i = rng_bounded(rng, names->remaining);
+    int drawn = names->deck[i];
+    names->deck[i] = names->deck[--names->remaining];
+    names->deck[names->remaining] = drawn;
+
+    return names->data + names->offsets[drawn];
+}
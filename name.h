@@ -2,26 +2,52 @@
 // AUTHOR: KRISTIAN KORIBSKY
 // DATE: 11.12.2022
 // ==========================================================================
+#ifndef NAME_H
+#define NAME_H
+
+#include "rng.h"
+
 #define NAMELIST_FILENAME "names.txt"
 
 
 /**
- * Generates random file line number.
- * @attention Uses rand() function so srand() initialization is needed!
- * @param line pointer to save generated line number
- * @param length pointer to save length of the longest word in file
- * @returns if the file cannot be read 1, otherwise if everything ok, 0 is returned
- * 
-*/
-int random_line(int *line, int *longest_word);
+ * Pool of names loaded from a name list file.
+ * The whole file is read into memory once, every line is terminated in place
+ * & indexed by its offset, so handing out a name never touches the file again.
+ * Names are drawn from a shuffled deck, no name repeats until the whole pool is used up.
+ */
+struct names {
+    char *data;         // file contents, lines terminated with '\0'
+    int *offsets;       // offset of every non-empty line in data
+    int count;          // number of names in the pool
+
+    int *deck;          // permutation of name indexes
+    int remaining;      // number of names not yet drawn from the deck
+};
+
+
+/**
+ * Loads name list file into a new name pool.
+ * @param filename name list file, one name per line
+ * @returns pointer to the allocated pool, NULL if the file cannot be read or memory could not be allocated
+ */
+struct names *names_load(const char *filename);
 
 
 /**
- * Gets random word on specified line.
- * @attention Uses rand() function so srand() initialization is needed!
- * @param line line number to read
- * @param max_l max length of buffer
- * @param name buffer where random name will be put
- * @returns if the file cannot be read 1, otherwise if everything ok, 0 is returned
-*/
-int get_line(const int line, const int len, char name[]);
\ No newline at end of file
+ * Frees name pool & its data.
+ * @param names pool to free (NULL is allowed)
+ */
+void names_destroy(struct names *names);
+
+
+/**
+ * Draws random name from the pool.
+ * Names do not repeat until every name of the pool was drawn, then the deck is reshuffled.
+ * @param names pool to draw from (NULL or empty pool is allowed)
+ * @param rng random generator
+ * @returns name owned by the pool, empty string if there are no names
+ */
+const char *names_random(struct names *names, struct rng *rng);
+
+#endif
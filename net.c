@@ -0,0 +1,180 @@
+// IMPLEMENTATION of library "net.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "net.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+
+void buffer_free(struct buffer *buffer)
+{
+    free(buffer->data);
+    *buffer = (struct buffer){0};
+}
+
+
+// makes room for the given number of bytes after the pending ones
+static int reserve(struct buffer *buffer, const size_t bytes)
+{
+    // sent or parsed bytes are dropped
+    if (buffer->start > 0) {
+        memmove(buffer->data, buffer->data + buffer->start, buffer->len - buffer->start);
+        buffer->len -= buffer->start;
+        buffer->start = 0;
+    }
+
+    if (buffer->len + bytes <= buffer->cap)
+        return 0;
+
+    size_t cap = buffer->cap > 0 ? buffer->cap : NET_RECEIVE;
+    while (cap < buffer->len + bytes)
+        cap *= 2;
+
+    char *data = realloc(buffer->data, cap);
+    if (data == NULL)
+        return 1;
+
+    buffer->data = data;
+    buffer->cap = cap;
+    return 0;
+}
+
+
+int buffer_append(struct buffer *buffer, const void *data, const size_t bytes)
+{
+    if (reserve(buffer, bytes))
+        return 1;
+
+    memcpy(buffer->data + buffer->len, data, bytes);
+    buffer->len += bytes;
+    return 0;
+}
+
+
+int buffer_message(struct buffer *buffer, const enum message_type type, const void *body, const size_t bytes)
+{
+    struct message_header header = { .type = type, .bytes = bytes };
+
+    return buffer_append(buffer, &header, sizeof(header)) || buffer_append(buffer, body, bytes);
+}
+
+
+// fills socket address, path which doesn't fit is refused
+static int address(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return 1;
+
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+
+int net_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    if (address(&addr, path))
+        return -1;
+
+    // socket of a server which didn't exit cleanly is still there
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, SERVER_BACKLOG) != 0
+        || fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+int net_connect(const char *path)
+{
+    struct sockaddr_un addr;
+    if (address(&addr, path))
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+int net_send(const int fd, struct buffer *buffer)
+{
+    while (buffer->start < buffer->len) {
+        // closed connection must not kill the process with SIGPIPE
+        ssize_t sent = send(fd, buffer->data + buffer->start, buffer->len - buffer->start, MSG_NOSIGNAL);
+        if (sent < 0)
+            return errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+
+        buffer->start += sent;
+    }
+
+    buffer->start = 0;
+    buffer->len = 0;
+    return 0;
+}
+
+
+int net_receive(const int fd, struct buffer *buffer, const size_t limit)
+{
+    while (buffer->len - buffer->start < limit) {
+        if (reserve(buffer, NET_RECEIVE))
+            return 1;
+
+        size_t room = buffer->cap - buffer->len, left = limit - (buffer->len - buffer->start);
+        ssize_t received = recv(fd, buffer->data + buffer->len, room < left ? room : left, 0);
+        if (received == 0)
+            return 1;
+        if (received < 0)
+            return errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+
+        buffer->len += received;
+    }
+
+    return 0;
+}
+
+
+bool net_next(struct buffer *buffer, struct message_header *header, const char **body)
+{
+    size_t pending = buffer->len - buffer->start;
+    if (pending < sizeof(struct message_header))
+        return false;
+
+    memcpy(header, buffer->data + buffer->start, sizeof(struct message_header));
+    if (pending - sizeof(struct message_header) < header->bytes)
+        return false;
+
+    *body = buffer->data + buffer->start + sizeof(struct message_header);
+    buffer->start += sizeof(struct message_header) + header->bytes;
+    return true;
+}
@@ -0,0 +1,142 @@
+// LIBRARY "net.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// kinds of messages exchanged over the socket
+enum message_type {
+    MESSAGE_WELCOME,            // server -> client: game settings & entity steered by the client (struct message_welcome)
+    MESSAGE_KEYFRAME,           // server -> client: whole state of the game (see delta.h)
+    MESSAGE_DELTA,              // server -> client: changes since the previous update (see delta.h)
+    MESSAGE_INPUT,              // client -> server: new direction of the steered entity (struct message_input)
+};
+
+
+/**
+ * Header of every message, body of the given number of bytes follows.
+ * Messages never leave the machine (UNIX socket), so they are sent in native byte order.
+ */
+struct message_header {
+    uint32_t type;              // enum message_type
+    uint32_t bytes;             // bytes of the body
+};
+
+
+/**
+ * Body of MESSAGE_WELCOME, the first message sent to every client.
+ */
+struct message_welcome {
+    uint32_t version;           // NET_VERSION
+    int32_t world_size;         // dimensions of the world
+    int32_t entities;           // number of entities (player included)
+    int32_t entity;             // entity steered by the client
+    uint64_t seed;              // seed of the game, entity names are drawn from it
+};
+
+
+/**
+ * Body of MESSAGE_INPUT.
+ */
+struct message_input {
+    int8_t row_vector;
+    int8_t col_vector;
+    uint16_t unused;
+};
+
+
+/**
+ * Growable byte buffer of a socket.
+ * Bytes from start to len are pending - not sent yet or not parsed yet.
+ */
+struct buffer {
+    char *data;
+    size_t start;               // first pending byte
+    size_t len;                 // end of pending bytes
+    size_t cap;                 // allocated bytes
+};
+
+
+/**
+ * Frees memory of the buffer & empties it.
+ * @param buffer buffer to free
+ */
+void buffer_free(struct buffer *buffer);
+
+
+/**
+ * Appends bytes at the end of the buffer.
+ * Sent or parsed bytes at the start are dropped first, so the buffer grows only with pending bytes.
+ * @param buffer buffer to append to
+ * @param data bytes to append
+ * @param bytes number of bytes
+ * @returns 0 if everything ok, 1 if memory could not be allocated
+ */
+int buffer_append(struct buffer *buffer, const void *data, const size_t bytes);
+
+
+/**
+ * Appends whole message (header & body) at the end of the buffer.
+ * @param buffer buffer to append to
+ * @param type enum message_type
+ * @param body body of the message
+ * @param bytes bytes of the body
+ * @returns 0 if everything ok, 1 if memory could not be allocated
+ */
+int buffer_message(struct buffer *buffer, const enum message_type type, const void *body, const size_t bytes);
+
+
+/**
+ * Creates non-blocking UNIX socket listening on the given path.
+ * Stale socket left at the path is replaced, any other file is not.
+ * @param path path of the socket
+ * @returns file descriptor of the socket, -1 if it could not be created
+ */
+int net_listen(const char *path);
+
+
+/**
+ * Connects to the UNIX socket on the given path, connected socket is non-blocking.
+ * @param path path of the socket
+ * @returns file descriptor of the connection, -1 if it could not be connected
+ */
+int net_connect(const char *path);
+
+
+/**
+ * Sends as many pending bytes of the buffer as the socket takes without blocking.
+ * @param fd connected socket
+ * @param buffer buffer with bytes to send, sent bytes are removed
+ * @returns 0 if everything ok (some bytes may still be pending), 1 if connection was closed
+ */
+int net_send(const int fd, struct buffer *buffer);
+
+
+/**
+ * Receives bytes waiting in the socket without blocking, until the buffer holds limit pending bytes.
+ * Bytes over the limit stay in the socket, so a flooding peer can't grow the buffer without bounds.
+ * @param fd connected socket
+ * @param buffer buffer to append received bytes to
+ * @param limit maximum number of pending (unparsed) bytes of the buffer
+ * @returns 0 if everything ok, 1 if connection was closed or memory could not be allocated
+ */
+int net_receive(const int fd, struct buffer *buffer, const size_t limit);
+
+
+/**
+ * Takes the next complete message out of the received bytes.
+ * @param buffer buffer with received bytes
+ * @param header pointer to store header of the message
+ * @param body pointer to store body of the message, it is valid until the buffer is changed
+ * @returns true if message was taken, false if no message is complete yet
+ */
+bool net_next(struct buffer *buffer, struct message_header *header, const char **body);
+
+
+#endif
@@ -0,0 +1,129 @@
+// IMPLEMENTATION of library "pool.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+
+#include <stdlib.h>
+
+
+struct worker_arg {
+    struct pool *pool;
+    int worker;
+};
+
+
+static void *worker_main(void *data)
+{
+    struct worker_arg *wa = data;
+    struct pool *pool = wa->pool;
+    int worker = wa->worker;
+    free(wa);
+
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->quit && pool->generation == seen)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->quit)
+            break;
+
+        seen = pool->generation;
+        pool_job job = pool->job;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        job(arg, worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+
+struct pool *pool_create(const int threads)
+{
+    struct pool *pool = calloc(1, sizeof(struct pool));
+    if (pool == NULL)
+        return NULL;
+
+    pool->workers = calloc(threads > 1 ? threads - 1 : 1, sizeof(pthread_t));
+    if (pool->workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // pool->threads counts only successfully started workers, so destroy joins the right ones
+    pool->threads = 1;
+    for (int i=1; i < threads; i++) {
+        struct worker_arg *wa = malloc(sizeof(struct worker_arg));
+        if (wa == NULL) {
+            pool_destroy(pool);
+            return NULL;
+        }
+        wa->pool = pool;
+        wa->worker = i;
+
+        if (pthread_create(&pool->workers[i-1], NULL, worker_main, wa) != 0) {
+            free(wa);
+            pool_destroy(pool);
+            return NULL;
+        }
+        pool->threads++;
+    }
+
+    return pool;
+}
+
+
+void pool_destroy(struct pool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i=0; i < pool->threads - 1; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+
+void pool_run(struct pool *pool, pool_job job, void *arg)
+{
+    if (pool->threads > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pool->job = job;
+        pool->arg = arg;
+        pool->running = pool->threads - 1;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    job(arg, 0);
+
+    if (pool->threads > 1) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->running > 0)
+            pthread_cond_wait(&pool->done, &pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
@@ -0,0 +1,61 @@
+// LIBRARY "pool.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+
+// job run by every thread of the pool, worker is 0 for the calling thread & 1..threads-1 for the others
+typedef void (*pool_job)(void *arg, const int worker);
+
+
+/**
+ * Fixed pool of worker threads running one job at a time.
+ * Calling thread takes part in every job as worker 0, so pool with 1 thread starts no threads at all.
+ */
+struct pool {
+    int threads;                // number of workers (calling thread included)
+    pthread_t *workers;         // started threads
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;       // signals new job (or quitting) to workers
+    pthread_cond_t done;        // signals finished job to the calling thread
+
+    pool_job job;               // current job
+    void *arg;                  // argument of the current job
+    unsigned long generation;   // number of jobs started, workers wait for it to change
+    int running;                // workers still running the current job
+    bool quit;                  // workers should exit
+};
+
+
+/**
+ * Starts pool of worker threads.
+ * @param threads number of workers including the calling thread (at least 1)
+ * @returns pointer to the started pool, NULL if threads could not be started
+ */
+struct pool *pool_create(const int threads);
+
+
+/**
+ * Stops every worker & frees the pool.
+ * @param pool pool to free (NULL is allowed)
+ */
+void pool_destroy(struct pool *pool);
+
+
+/**
+ * Runs job on every worker & waits until all of them finish.
+ * Work is split by the job itself, eg. by taking items from a shared atomic counter.
+ * @param pool pool to run the job on
+ * @param job function run by every worker
+ * @param arg argument passed to every worker
+ */
+void pool_run(struct pool *pool, pool_job job, void *arg);
+
+
+#endif
@@ -0,0 +1,165 @@
+// IMPLEMENTATION of library "profile.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "profile.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+
+static const char *phase_names[PHASES] = {
+    "blob_spawn", "update_bot_vectors", "update_player_vectors", "update_positions", "eval_positions", "render_viewport", "network"
+};
+
+
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *)a;
+    long y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+
+// number of rows with valid samples & index of the oldest one
+static int recorded(const struct profile *profile, int *oldest)
+{
+    if (profile->count < PROFILE_TICKS) {
+        *oldest = 0;
+        return profile->count;
+    }
+
+    *oldest = (profile->head + 1) % PROFILE_TICKS;
+    return PROFILE_TICKS;
+}
+
+
+struct profile *profile_create(void)
+{
+    struct profile *profile = calloc(1, sizeof(struct profile));
+    if (profile == NULL)
+        return NULL;
+
+    profile->head = -1;
+    return profile;
+}
+
+
+void profile_destroy(struct profile *profile)
+{
+    free(profile);
+}
+
+
+void profile_tick(struct profile *profile, const unsigned long tick)
+{
+    profile->head = (profile->head + 1) % PROFILE_TICKS;
+    profile->count++;
+    profile->ticks[profile->head] = tick;
+    profile->jitter[profile->head] = 0;
+
+    for (int i=0; i < PHASES; i++)
+        profile->samples[profile->head][i] = 0;
+}
+
+
+long profile_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+
+void profile_stop(struct profile *profile, const enum phase phase, const long start)
+{
+    if (profile->head < 0)
+        return;
+
+    profile->samples[profile->head][phase] += profile_now() - start;
+}
+
+
+void profile_jitter(struct profile *profile, const long jitter)
+{
+    if (profile->head < 0)
+        return;
+
+    profile->jitter[profile->head] = jitter;
+}
+
+
+void profile_stats(const struct profile *profile, long *min, long *avg, long *p99)
+{
+    int oldest;
+    int n = recorded(profile, &oldest);
+    *min = *avg = *p99 = 0;
+    if (n == 0)
+        return;
+
+    long totals[PROFILE_TICKS];
+    long sum = 0;
+    for (int i=0; i < n; i++) {
+        totals[i] = 0;
+        for (int ii=0; ii < PHASES; ii++)
+            totals[i] += profile->samples[i][ii];
+        sum += totals[i];
+    }
+
+    qsort(totals, n, sizeof(long), compare_long);
+    *min = totals[0];
+    *avg = sum / n;
+    *p99 = totals[(n - 1) * 99 / 100];
+}
+
+
+void profile_jitter_stats(const struct profile *profile, long *avg, long *max)
+{
+    int oldest;
+    int n = recorded(profile, &oldest);
+    *avg = *max = 0;
+    if (n == 0)
+        return;
+
+    long sum = 0;
+    for (int i=0; i < n; i++) {
+        sum += profile->jitter[i];
+        if (profile->jitter[i] > *max)
+            *max = profile->jitter[i];
+    }
+    *avg = sum / n;
+}
+
+
+int profile_dump(const struct profile *profile, const char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return 1;
+
+    // header
+    fprintf(fp, "tick");
+    for (int i=0; i < PHASES; i++)
+        fprintf(fp, ",%s", phase_names[i]);
+    fprintf(fp, ",total,jitter\n");
+
+    int oldest;
+    int n = recorded(profile, &oldest);
+    for (int i=0; i < n; i++) {
+        int row = (oldest + i) % PROFILE_TICKS;
+        long total = 0;
+
+        fprintf(fp, "%lu", profile->ticks[row]);
+        for (int ii=0; ii < PHASES; ii++) {
+            fprintf(fp, ",%ld", profile->samples[row][ii]);
+            total += profile->samples[row][ii];
+        }
+        fprintf(fp, ",%ld,%ld\n", total, profile->jitter[row]);
+    }
+
+    fclose(fp);
+    return 0;
+}
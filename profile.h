@@ -0,0 +1,114 @@
+// LIBRARY "profile.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "config.h"
+
+
+// measured phases of one game tick
+enum phase {
+    PHASE_BLOB_SPAWN,
+    PHASE_BOT_VECTORS,
+    PHASE_PLAYER_VECTORS,
+    PHASE_POSITIONS,
+    PHASE_EVAL,
+    PHASE_RENDER,
+    PHASE_NETWORK,
+    PHASES
+};
+
+
+// measures duration of the statement as the given phase, when profiler isn't NULL
+#define PROFILED(profile, phase, statement) do { \
+        long profiled_start = (profile) != NULL ? profile_now() : 0; \
+        statement; \
+        if ((profile) != NULL) \
+            profile_stop((profile), (phase), profiled_start); \
+    } while (0)
+
+
+/**
+ * Per-tick profiler of game loop phases.
+ * Nanosecond timings of the last PROFILE_TICKS ticks are kept in a ring buffer.
+ */
+struct profile {
+    long samples[PROFILE_TICKS][PHASES];    // duration of every phase in nanoseconds
+    unsigned long ticks[PROFILE_TICKS];     // game tick of every sample row
+    long jitter[PROFILE_TICKS];             // lateness of every tick start in nanoseconds, 0 when ticks aren't scheduled
+    unsigned long count;                    // number of recorded ticks
+    int head;                               // row of the current tick
+};
+
+
+/**
+ * Allocates empty profiler.
+ * @returns pointer to the allocated profiler, NULL if memory could not be allocated
+ */
+struct profile *profile_create(void);
+
+
+/**
+ * Frees profiler.
+ * @param profile profiler to free (NULL is allowed)
+ */
+void profile_destroy(struct profile *profile);
+
+
+/**
+ * Starts recording new tick, the oldest recorded tick is overwritten when the buffer is full.
+ * @param tick game tick number
+ */
+void profile_tick(struct profile *profile, const unsigned long tick);
+
+
+/**
+ * Reads monotonic clock.
+ * @returns current time in nanoseconds
+ */
+long profile_now(void);
+
+
+/**
+ * Adds time elapsed since start to the phase of the current tick.
+ * @param phase measured phase
+ * @param start time returned by profile_now() when the phase started
+ */
+void profile_stop(struct profile *profile, const enum phase phase, const long start);
+
+
+/**
+ * Records how late the current tick started.
+ * @param jitter lateness measured by the scheduler in nanoseconds
+ */
+void profile_jitter(struct profile *profile, const long jitter);
+
+
+/**
+ * Calculates statistics of the whole tick duration (sum of all phases) over the recorded ticks.
+ * @param min pointer to store the shortest tick in nanoseconds
+ * @param avg pointer to store the average tick in nanoseconds
+ * @param p99 pointer to store the 99th percentile of ticks in nanoseconds
+ */
+void profile_stats(const struct profile *profile, long *min, long *avg, long *p99);
+
+
+/**
+ * Calculates statistics of tick start jitter over the recorded ticks.
+ * @param avg pointer to store the average jitter in nanoseconds
+ * @param max pointer to store the worst jitter in nanoseconds
+ */
+void profile_jitter_stats(const struct profile *profile, long *avg, long *max);
+
+
+/**
+ * Writes recorded ticks as CSV trace (one row per tick, one column per phase followed by total & jitter, oldest tick first).
+ * @param filename path to the trace file
+ * @returns if the file cannot be written 1, otherwise if everything ok, 0 is returned
+ */
+int profile_dump(const struct profile *profile, const char *filename);
+
+
+#endif
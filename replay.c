@@ -0,0 +1,125 @@
+// IMPLEMENTATION of library "replay.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "config.h"
+#include "replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+struct replay *replay_create(const char *filename, const uint64_t seed, const int world_size, const int bots)
+{
+    struct replay *replay = calloc(1, sizeof(struct replay));
+    if (replay == NULL)
+        return NULL;
+
+    memcpy(replay->header.magic, REPLAY_MAGIC, sizeof(replay->header.magic));
+    replay->header.version = REPLAY_VERSION;
+    replay->header.seed = seed;
+    replay->header.world_size = world_size;
+    replay->header.bots = bots;
+
+    replay->file = fopen(filename, "wb");
+    if (replay->file == NULL || fwrite(&replay->header, sizeof(struct replay_header), 1, replay->file) != 1) {
+        replay_close(replay);
+        return NULL;
+    }
+
+    return replay;
+}
+
+
+struct replay *replay_load(const char *filename)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    struct replay *replay = calloc(1, sizeof(struct replay));
+    if (replay == NULL || fread(&replay->header, sizeof(struct replay_header), 1, fp) != 1
+        || memcmp(replay->header.magic, REPLAY_MAGIC, sizeof(replay->header.magic)) != 0
+        || replay->header.version != REPLAY_VERSION
+        || replay->header.world_size < MIN_WORLD_SIZE || replay->header.world_size > MAX_WORLD_SIZE
+        || replay->header.bots < MIN_BOT_COUNT || replay->header.bots > MAX_BOT_COUNT) {
+        fclose(fp);
+        free(replay);
+        return NULL;
+    }
+
+    // records are read at once, their number follows from the file size
+    long start = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    replay->count = (ftell(fp) - start) / (long) sizeof(struct replay_record);
+    fseek(fp, start, SEEK_SET);
+
+    replay->records = malloc((replay->count > 0 ? replay->count : 1) * sizeof(struct replay_record));
+    if (replay->records == NULL || (long) fread(replay->records, sizeof(struct replay_record), replay->count, fp) != replay->count) {
+        fclose(fp);
+        replay_close(replay);
+        return NULL;
+    }
+
+    fclose(fp);
+    return replay;
+}
+
+
+void replay_record(struct replay *replay, const enum replay_type type, const unsigned long tick, const int row_vector, const int col_vector, const float difficulty)
+{
+    struct replay_record record = {
+        .tick = tick, .type = type, .row_vector = row_vector, .col_vector = col_vector,
+        .difficulty = lroundf(difficulty * 100)
+    };
+
+    fwrite(&record, sizeof(struct replay_record), 1, replay->file);
+}
+
+
+bool replay_next_game(struct replay *replay, float *difficulty)
+{
+    while (replay->next < replay->count && replay->records[replay->next].type != REPLAY_GAME)
+        replay->next++;
+
+    if (replay->next >= replay->count)
+        return false;
+
+    *difficulty = replay->records[replay->next++].difficulty / 100.0f;
+    return true;
+}
+
+
+bool replay_input(struct replay *replay, const unsigned long tick, int *row_vector, int *col_vector)
+{
+    for (; replay->next < replay->count && replay->records[replay->next].tick <= tick; replay->next++) {
+        const struct replay_record *record = &replay->records[replay->next];
+
+        if (record->type != REPLAY_INPUT)
+            return false;
+
+        *row_vector = record->row_vector;
+        *col_vector = record->col_vector;
+    }
+
+    // replay cut short (eg. game was killed while recording) ends with its last record
+    return replay->next < replay->count;
+}
+
+
+int replay_close(struct replay *replay)
+{
+    if (replay == NULL)
+        return 0;
+
+    int failed = 0;
+    if (replay->file != NULL) {
+        failed = ferror(replay->file);
+        failed |= fclose(replay->file) != 0;
+    }
+
+    free(replay->records);
+    free(replay);
+    return failed;
+}
@@ -0,0 +1,119 @@
+// LIBRARY "replay.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+// kinds of replay records
+enum replay_type {
+    REPLAY_GAME,                // new game was started with the given difficulty
+    REPLAY_INPUT,               // player changed direction before the given tick
+    REPLAY_END,                 // game was left after the given number of ticks
+};
+
+
+/**
+ * Header at the start of every replay file.
+ * Game is simulated from the same seed again, so nothing but the game settings is needed.
+ */
+struct replay_header {
+    char magic[4];              // REPLAY_MAGIC
+    uint32_t version;           // REPLAY_VERSION
+    uint64_t seed;              // seed of the game's random generator
+    int32_t world_size;         // dimensions of the world
+    int32_t bots;               // number of bots
+};
+
+
+/**
+ * Single record of the replay file.
+ */
+struct replay_record {
+    uint32_t tick;              // game tick of the record
+    uint8_t type;               // enum replay_type
+    int8_t row_vector;          // player vectors of REPLAY_INPUT
+    int8_t col_vector;
+    uint8_t difficulty;         // bot difficulty of REPLAY_GAME in percent
+};
+
+
+/**
+ * Replay being recorded into a file or played back from memory.
+ * Only ticks with player input are recorded, every other tick follows from the seed.
+ */
+struct replay {
+    struct replay_header header;
+    FILE *file;                 // file being recorded, NULL when replay is played back
+
+    struct replay_record *records;  // records of played back replay
+    long count;                 // number of records
+    long next;                  // record to play next
+};
+
+
+/**
+ * Starts recording of a new replay.
+ * @param filename file to record into, it is overwritten
+ * @param seed seed of the game's random generator
+ * @param world_size dimensions of the world
+ * @param bots number of bots
+ * @returns pointer to the recorded replay, NULL if file could not be created
+ */
+struct replay *replay_create(const char *filename, const uint64_t seed, const int world_size, const int bots);
+
+
+/**
+ * Loads whole replay file for playback.
+ * @param filename recorded file
+ * @returns pointer to the loaded replay, NULL if file could not be read or isn't a replay of this version
+ */
+struct replay *replay_load(const char *filename);
+
+
+/**
+ * Appends record to the recorded replay.
+ * @param replay recorded replay
+ * @param type kind of the record
+ * @param tick game tick of the record
+ * @param row_vector player's row vector (REPLAY_INPUT)
+ * @param col_vector player's col vector (REPLAY_INPUT)
+ * @param difficulty bot difficulty level (REPLAY_GAME)
+ */
+void replay_record(struct replay *replay, const enum replay_type type, const unsigned long tick, const int row_vector, const int col_vector, const float difficulty);
+
+
+/**
+ * Moves playback to the next recorded game.
+ * @param replay played back replay
+ * @param difficulty pointer to store bot difficulty level of the game
+ * @returns true if there is next game, false at the end of the replay
+ */
+bool replay_next_game(struct replay *replay, float *difficulty);
+
+
+/**
+ * Plays back player input recorded before the given tick.
+ * @param replay played back replay
+ * @param tick game tick about to be simulated
+ * @param row_vector pointer to player's row vector, updated when direction changed
+ * @param col_vector pointer to player's col vector, updated when direction changed
+ * @returns true if the game continues with this tick, false if it was left before it
+ */
+bool replay_input(struct replay *replay, const unsigned long tick, int *row_vector, int *col_vector);
+
+
+/**
+ * Finishes recording & frees replay.
+ * @param replay replay to free (NULL is allowed)
+ * @returns 0 if everything ok, 1 if recorded file could not be written
+ */
+int replay_close(struct replay *replay);
+
+
+#endif
@@ -0,0 +1,116 @@
+// IMPLEMENTATION of library "rng.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "rng.h"
+
+
+static inline uint64_t rotl(const uint64_t x, const int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+
+// splitmix64, spreads a single seed over the whole state (all-zero state is never produced)
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+
+// advances generator by 2^128 calls of rng_next()
+static void rng_jump(struct rng *rng)
+{
+    static const uint64_t jump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+    uint64_t s[4] = {0};
+    for (int i=0; i < 4; i++)
+        for (int b=0; b < 64; b++) {
+            if (jump[i] & (1ULL << b))
+                for (int j=0; j < 4; j++)
+                    s[j] ^= rng->s[j];
+            rng_next(rng);
+        }
+
+    for (int j=0; j < 4; j++)
+        rng->s[j] = s[j];
+}
+
+
+void rng_seed(struct rng *rng, const uint64_t seed)
+{
+    uint64_t x = seed;
+    for (int i=0; i < 4; i++)
+        rng->s[i] = splitmix64(&x);
+}
+
+
+void rng_stream(struct rng *rng, const uint64_t seed, const int stream)
+{
+    rng_seed(rng, seed);
+    for (int i=0; i < stream; i++)
+        rng_jump(rng);
+}
+
+
+uint64_t rng_next(struct rng *rng)
+{
+    uint64_t *s = rng->s;
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+
+uint32_t rng_bounded(struct rng *rng, const uint32_t range)
+{
+    uint32_t x = rng_next(rng) >> 32;
+    if (range == 0)
+        return x;
+
+    // Lemire's multiply-shift, rejecting the few low products that would make some values more likely
+    uint64_t m = (uint64_t) x * range;
+    uint32_t low = (uint32_t) m;
+    if (low < range) {
+        uint32_t threshold = -range % range;
+        while (low < threshold) {
+            x = rng_next(rng) >> 32;
+            m = (uint64_t) x * range;
+            low = (uint32_t) m;
+        }
+    }
+    return m >> 32;
+}
+
+
+uint64_t rng_bounded64(struct rng *rng, const uint64_t range)
+{
+    // the lowest numbers are rejected, so that every remainder is equally likely
+    uint64_t threshold = -range % range;
+    uint64_t x = rng_next(rng);
+    while (x < threshold)
+        x = rng_next(rng);
+
+    return x % range;
+}
+
+
+int rng_int(struct rng *rng, const int min, const int max)
+{
+    if (min > max)
+        return min;
+
+    uint32_t range = (uint32_t) ((int64_t) max - min + 1);
+    return (int) ((int64_t) min + rng_bounded(rng, range));
+}
@@ -0,0 +1,75 @@
+// LIBRARY "rng.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+
+/**
+ * State of xoshiro256** pseudo-random generator.
+ * Every generator owns its state, so independent streams can be used side by side (eg. one per thread)
+ * & the same seed always reproduces the same sequence.
+ */
+struct rng {
+    uint64_t s[4];
+};
+
+
+/**
+ * Initializes generator from a single seed value.
+ * @param rng generator to initialize
+ * @param seed any 64-bit value (0 is allowed)
+ */
+void rng_seed(struct rng *rng, const uint64_t seed);
+
+
+/**
+ * Initializes generator to the given independent stream of the seed.
+ * Streams are 2^128 numbers apart, so their sequences never overlap in practice.
+ * @param rng generator to initialize
+ * @param seed any 64-bit value (0 is allowed)
+ * @param stream index of the stream, 0 is the same as rng_seed()
+ */
+void rng_stream(struct rng *rng, const uint64_t seed, const int stream);
+
+
+/**
+ * Generates next pseudo-random 64-bit number.
+ * @param rng generator state
+ * @returns uniformly distributed 64-bit number
+ */
+uint64_t rng_next(struct rng *rng);
+
+
+/**
+ * Generates pseudo-random number in range [0, range) without modulo bias.
+ * @param rng generator state
+ * @param range number of possible values (0 yields full 32-bit range)
+ * @returns uniformly distributed number smaller than range
+ */
+uint32_t rng_bounded(struct rng *rng, const uint32_t range);
+
+
+/**
+ * Generates pseudo-random number in 64-bit range [0, range) without modulo bias.
+ * @param rng generator state
+ * @param range number of possible values (at least 1)
+ * @returns uniformly distributed number smaller than range
+ */
+uint64_t rng_bounded64(struct rng *rng, const uint64_t range);
+
+
+/**
+ * Generates pseudo-random int from the given inclusive range without modulo bias.
+ * @param rng generator state
+ * @param min minimum generated number
+ * @param max maximum generated number
+ * @returns randomly generated integer, min if min > max
+ */
+int rng_int(struct rng *rng, const int min, const int max);
+
+
+#endif
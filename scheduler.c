@@ -0,0 +1,82 @@
+// IMPLEMENTATION of library "scheduler.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "scheduler.h"
+#include "config.h"
+
+#include <errno.h>
+
+#define NSEC_PER_SEC 1000000000L
+
+
+// signed difference a - b in nanoseconds
+static long diff_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+
+static void add_ns(struct timespec *ts, const long ns)
+{
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= NSEC_PER_SEC) {
+        ts->tv_nsec -= NSEC_PER_SEC;
+        ts->tv_sec++;
+    }
+}
+
+
+void scheduler_start(struct scheduler *scheduler, const int milliseconds)
+{
+    scheduler->period = milliseconds * 1000000L;
+    scheduler->skipped = 0;
+    scheduler->jitter = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &scheduler->next);
+    add_ns(&scheduler->next, scheduler->period);
+}
+
+
+bool scheduler_render(struct scheduler *scheduler)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // behind schedule - give the time to simulation
+    if (diff_ns(&now, &scheduler->next) > 0 && scheduler->skipped < MAX_FRAMESKIP) {
+        scheduler->skipped++;
+        return false;
+    }
+
+    scheduler->skipped = 0;
+    return true;
+}
+
+
+int scheduler_wait(struct scheduler *scheduler)
+{
+    // returns immediately when the deadline has already passed, interrupted sleep continues until the same deadline
+    int error;
+    do {
+        error = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &scheduler->next, NULL);
+    } while (error == EINTR);
+    if (error != 0)
+        return error;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    scheduler->jitter = diff_ns(&now, &scheduler->next);
+
+    // too far behind (e.g. process was stopped) - don't try to catch up with burst of ticks
+    if (scheduler->jitter > MAX_TICK_LAG * scheduler->period) {
+        scheduler->next = now;
+        scheduler->skipped = 0;
+    }
+
+    add_ns(&scheduler->next, scheduler->period);
+    return 0;
+}
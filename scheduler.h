@@ -0,0 +1,50 @@
+// LIBRARY "scheduler.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <time.h>
+
+
+/**
+ * Fixed timestep scheduler of game ticks.
+ * Ticks are aligned to absolute deadlines on CLOCK_MONOTONIC, so time spent in simulation & rendering
+ * doesn't prolong the tick period. When the game falls behind, renders are skipped, simulation ticks never are.
+ */
+struct scheduler {
+    long period;                // nanoseconds between 2 ticks
+    struct timespec next;       // absolute deadline of the next tick
+    int skipped;                // number of renders skipped in a row
+    long jitter;                // measured lateness of the last tick start in nanoseconds
+};
+
+
+/**
+ * Starts scheduling ticks from now on.
+ * @param scheduler scheduler to (re)start
+ * @param milliseconds period of one tick
+ */
+void scheduler_start(struct scheduler *scheduler, const int milliseconds);
+
+
+/**
+ * Decides whether current tick should be rendered.
+ * Render is skipped when the deadline of the next tick has already passed, but at most MAX_FRAMESKIP times in a row.
+ * @returns true if frame should be rendered, false otherwise
+ */
+bool scheduler_render(struct scheduler *scheduler);
+
+
+/**
+ * Sleeps until the deadline of the next tick & measures how late the wake up was.
+ * If the game is more than MAX_TICK_LAG ticks behind, deadlines are moved to now instead of catching up.
+ * Sleep interrupted by a signal continues until the same deadline.
+ * @returns 0 if everything ok, error number of clock_nanosleep() otherwise (deadline is then left unchanged)
+ */
+int scheduler_wait(struct scheduler *scheduler);
+
+
+#endif
@@ -0,0 +1,307 @@
+// IMPLEMENTATION of library "server.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "server.h"
+#include "stencil.h"
+#include "scheduler.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+
+static volatile sig_atomic_t stopped = 0;
+
+
+static void stop(int signal)
+{
+    (void) signal;
+    stopped = 1;
+}
+
+
+static void drop(struct server *server, struct client *client)
+{
+    close(client->fd);
+    buffer_free(&client->in);
+    buffer_free(&client->out);
+    server->steered[client->entity] = false;
+    client->fd = -1;
+    server->count--;
+}
+
+
+// accepts waiting connections, every client gets the first living entity nobody steers
+static void accept_clients(struct server *server)
+{
+    const struct entities *ent = server->game->ent;
+    int fd;
+
+    while ((fd = accept(server->fd, NULL, NULL)) >= 0) {
+        struct client *client = NULL;
+        for (int i=0; i < MAX_CLIENTS && client == NULL; i++)
+            if (server->clients[i].fd == -1)
+                client = &server->clients[i];
+
+        int entity = 0;
+        while (entity < ent->n && (!ent->alive[entity] || server->steered[entity]))
+            entity++;
+
+        // server is full
+        if (client == NULL || entity == ent->n || fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+            close(fd);
+            continue;
+        }
+
+        struct message_welcome welcome = {
+            .version = NET_VERSION, .world_size = server->game->world->size, .entities = ent->n, .entity = entity,
+            .seed = server->game->seed
+        };
+        *client = (struct client){ .fd = fd, .entity = entity, .spawned = true, .keyframe = true };
+        server->steered[entity] = true;
+        server->count++;
+
+        if (buffer_message(&client->out, MESSAGE_WELCOME, &welcome, sizeof(welcome)))
+            drop(server, client);
+    }
+}
+
+
+// applies directions received from clients, the last one of the tick wins
+static void receive_inputs(struct server *server)
+{
+    struct entities *ent = server->game->ent;
+
+    for (int i=0; i < MAX_CLIENTS; i++) {
+        struct client *client = &server->clients[i];
+        if (client->fd == -1)
+            continue;
+
+        // client filling the whole backlog within a tick floods the server
+        if (net_receive(client->fd, &client->in, CLIENT_BACKLOG) || client->in.len - client->in.start >= CLIENT_BACKLOG) {
+            drop(server, client);
+            continue;
+        }
+
+        struct message_header header;
+        const char *body;
+        while (net_next(&client->in, &header, &body)) {
+            struct message_input input;
+            if (header.type != MESSAGE_INPUT || header.bytes != sizeof(input)) {
+                drop(server, client);
+                break;
+            }
+
+            memcpy(&input, body, sizeof(input));
+            if (input.row_vector >= -VERTICAL_MODIFIER && input.row_vector <= VERTICAL_MODIFIER
+                && input.col_vector >= -HORIZONTAL_MODIFIER && input.col_vector <= HORIZONTAL_MODIFIER) {
+                ent->row_vector[client->entity] = input.row_vector;
+                ent->col_vector[client->entity] = input.col_vector;
+            }
+        }
+    }
+}
+
+
+// round is over when a single entity is left or when every client was eliminated
+// clients whose entities weren't spawned in this round don't count
+static bool round_over(const struct server *server)
+{
+    const struct game *game = server->game;
+    if (game->alive <= PLAYERS)
+        return true;
+
+    bool spawned = false, playing = false;
+    for (int i=0; i < MAX_CLIENTS; i++) {
+        const struct client *client = &server->clients[i];
+        if (client->fd == -1 || !client->spawned)
+            continue;
+
+        spawned = true;
+        playing |= game->ent->alive[client->entity];
+    }
+
+    return spawned && !playing;
+}
+
+
+// starts new round, entities of clients may not fit into a crowded world
+static void new_round(struct server *server)
+{
+    game_reset(server->game);
+
+    for (int i=0; i < MAX_CLIENTS; i++) {
+        struct client *client = &server->clients[i];
+        if (client->fd != -1)
+            client->spawned = server->game->ent->alive[client->entity];
+    }
+}
+
+
+// encodes updates of the tick once, queues them for every client & publishes them to spectators
+static void send_updates(struct server *server, const bool reset)
+{
+    // spectators get a delta of every tick, keyframe only for a new round or when the feed lost updates
+    bool spectated = server->feed != NULL;
+    bool resync = spectated && (feed_keyframe(server->feed) || reset);
+
+    bool synced = spectated && !resync, keyframe = resync;
+    for (int i=0; i < MAX_CLIENTS; i++) {
+        struct client *client = &server->clients[i];
+        client->keyframe |= reset;
+        synced |= client->fd != -1 && !client->keyframe;
+        keyframe |= client->fd != -1 && client->keyframe;
+    }
+
+    // delta needs to be encoded before the keyframe, both are then based on the same previous update
+    server->update.start = server->update.len = 0;
+    server->keyframe.start = server->keyframe.len = 0;
+    bool failed = (synced && delta_update(server->delta, server->game, &server->update))
+        || (keyframe && delta_keyframe(server->delta, server->game, &server->keyframe));
+
+    // empty update is taken as lost by the feed, which then asks for a keyframe
+    if (spectated)
+        feed_publish(server->feed, failed ? &(struct buffer){ 0 } : resync ? &server->keyframe : &server->update);
+
+    for (int i=0; i < MAX_CLIENTS; i++) {
+        struct client *client = &server->clients[i];
+        if (client->fd == -1)
+            continue;
+
+        const struct buffer *update = client->keyframe ? &server->keyframe : &server->update;
+        if (failed || buffer_append(&client->out, update->data + update->start, update->len - update->start)
+            || client->out.len - client->out.start > CLIENT_BACKLOG || net_send(client->fd, &client->out)) {
+            drop(server, client);
+            continue;
+        }
+        client->keyframe = false;
+    }
+}
+
+
+static void summary(const struct server *server, const int round)
+{
+    const struct game *game = server->game;
+
+    printf("round=%d ticks=%lu alive=%d clients=%d blobs=%d kills=%lu blobs_eaten=%lu\n",
+        round, game->ticks, game->alive, server->count, game->blobs, game->kills, game->blobs_eaten);
+    fflush(stdout);
+}
+
+
+static void server_destroy(struct server *server, const char *path)
+{
+    for (int i=0; i < MAX_CLIENTS; i++)
+        if (server->clients[i].fd != -1)
+            drop(server, &server->clients[i]);
+
+    if (server->fd >= 0) {
+        close(server->fd);
+        unlink(path);
+    }
+    feed_destroy(server->feed);
+    buffer_free(&server->update);
+    buffer_free(&server->keyframe);
+    delta_destroy(server->delta);
+    free(server->steered);
+    game_destroy(server->game);
+}
+
+
+int server_run(const struct options *options)
+{
+    struct server server = { .fd = -1 };
+    for (int i=0; i < MAX_CLIENTS; i++)
+        server.clients[i].fd = -1;
+
+    server.game = game_create(options->world_size, options->bots, options->seed);
+    if (server.game != NULL) {
+        server.delta = delta_create(server.game->ent->n);
+        server.steered = calloc(server.game->ent->n, sizeof(bool));
+    }
+    if (server.game == NULL || server.delta == NULL || server.steered == NULL
+        || (options->profile != NULL && (server.game->profile = profile_create()) == NULL)) {
+        server_destroy(&server, options->serve);
+        printf("Not enough memory to create the world.\n");
+        return 1;
+    }
+    if (game_threads(server.game, options->threads)) {
+        server_destroy(&server, options->serve);
+        printf("Threads could not be started.\n");
+        return 1;
+    }
+    if ((server.fd = net_listen(options->serve)) < 0) {
+        server_destroy(&server, options->serve);
+        printf("Socket %s could not be created.\n", options->serve);
+        return 1;
+    }
+    if (options->spectate != NULL && (server.feed = feed_create(options->spectate, server.game)) == NULL) {
+        server_destroy(&server, options->serve);
+        printf("Socket %s could not be created.\n", options->spectate);
+        return 1;
+    }
+
+    struct sigaction action = { .sa_handler = stop };
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    struct game *game = server.game;
+    struct entities *ent = game->ent;
+    game->ai.steered = server.steered;
+    game_reset(game);
+
+    int round = 1;
+    bool reset = true, failed = false;
+    struct scheduler scheduler;
+    scheduler_start(&scheduler, TICK_RATE);
+    for (unsigned long tick=0; !stopped && !failed && (!options->headless || tick < options->ticks); tick++) {
+        // lateness of this tick was measured by the previous wait
+        if (game->profile != NULL) {
+            profile_tick(game->profile, game->ticks);
+            profile_jitter(game->profile, scheduler.jitter);
+        }
+
+        accept_clients(&server);
+        PROFILED(game->profile, PHASE_PLAYER_VECTORS, receive_inputs(&server));
+
+        // player nobody steers wanders like in headless games
+        if (!server.steered[PLAYER] && game->ticks % VECTOR_UPDATE_RATE == 0) {
+            ent->row_vector[PLAYER] = rng_int(&game->rng, -VERTICAL_MODIFIER, VERTICAL_MODIFIER);
+            ent->col_vector[PLAYER] = rng_int(&game->rng, -HORIZONTAL_MODIFIER, HORIZONTAL_MODIFIER);
+        }
+
+        game_tick(game);
+
+        // clients keep their entities in the next round, whole new world is sent to them
+        if (round_over(&server)) {
+            summary(&server, round++);
+            new_round(&server);
+            reset = true;
+        }
+
+        PROFILED(game->profile, PHASE_NETWORK, send_updates(&server, reset));
+        reset = false;
+
+        if (scheduler_wait(&scheduler)) {
+            printf("Ticks could not be scheduled.\n");
+            failed = true;
+        }
+    }
+    summary(&server, round);
+
+    if (game->profile != NULL && profile_dump(game->profile, options->profile))
+        printf("Profiler trace could not be written to %s.\n", options->profile);
+
+    server_destroy(&server, options->serve);
+    stencil_free();
+    return failed;
+}
@@ -0,0 +1,62 @@
+// LIBRARY "server.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+
+#include "config.h"
+#include "game.h"
+#include "delta.h"
+#include "net.h"
+#include "feed.h"
+
+
+/**
+ * Client connected to the server, it steers a single entity.
+ */
+struct client {
+    int fd;                     // connection, -1 when the slot is free
+    int entity;                 // entity steered by the client
+    bool spawned;               // entity was spawned in the current round, otherwise client only watches until the next one
+    bool keyframe;              // whole state needs to be sent instead of the next delta
+    struct buffer in;           // received bytes
+    struct buffer out;          // bytes waiting until the client takes them
+};
+
+
+/**
+ * Authoritative multiplayer server.
+ * Server owns the simulation, clients only send their directions & receive updates of the game state.
+ * Every tick a single delta is encoded & copied to every client, so the cost of a client is only the copy of changes.
+ */
+struct server {
+    int fd;                     // listening socket
+    struct game *game;
+    struct delta *delta;        // encoder of updates shared by every client
+    bool *steered;              // entities steered by clients, bots don't decide for them
+    struct client clients[MAX_CLIENTS];
+    int count;                  // connected clients
+    struct buffer update;       // delta of the current tick
+    struct buffer keyframe;     // keyframe of the current tick, encoded only when a client or the feed needs it
+    struct feed *feed;          // spectator feed, NULL when spectators aren't allowed
+};
+
+
+/**
+ * Runs multiplayer server on a UNIX socket until it is interrupted (SIGINT, SIGTERM).
+ * Every connected client takes over a living entity, the first one takes the player.
+ * New round starts when at most 1 entity is left or every entity steered by clients was eliminated.
+ * Client whose entity doesn't fit into a crowded world sits out the round, so it can't end the round right away.
+ * Ticks are scheduled at TICK_RATE, client which doesn't keep up with updates (CLIENT_BACKLOG) is dropped.
+ * Spectators watch the game on another socket (options->spectate), every tick is published to them through a feed.
+ * Prints summary of every round to the standard output.
+ * @param options game settings, socket is given in options->serve, headless option stops the server after options->ticks
+ * @returns 0 if everything ok, 1 if socket or game could not be created or ticks could not be scheduled
+ */
+int server_run(const struct options *options);
+
+
+#endif
@@ -0,0 +1,382 @@
+// IMPLEMENTATION of library "snapshot.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "snapshot.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// sections are copied from memory as they are
+_Static_assert(sizeof(int) == sizeof(int32_t) && sizeof(long) == sizeof(int64_t), "snapshot sections need 32-bit int & 64-bit long");
+
+#define PADDED(bytes) (((bytes) + 7) & ~(size_t)7)
+#define CELLS_BATCH 256         // entity cells written at once
+
+
+// sizes of all sections of the snapshot
+struct sections {
+    size_t chunks;
+    size_t table;
+    size_t ints;                // single int array of entities, alive flags have their own size
+    size_t alive;
+};
+
+
+static size_t sections(struct sections *s, const long chunks, const int cells, const int n)
+{
+    s->chunks = chunks * sizeof(struct snapshot_chunk);
+    s->table = cells * sizeof(struct snapshot_cell);
+    s->ints = PADDED(n * sizeof(int));
+    s->alive = PADDED(n * sizeof(bool));
+
+    return sizeof(struct snapshot_header) + s->chunks + s->table + 6 * s->ints + s->alive;
+}
+
+
+// writes whole buffer & pads it with zeros, only system calls are used so that forked child can call it
+static int write_all(const int fd, const void *data, const size_t bytes, const size_t padded)
+{
+    static const char zeros[8];
+    const char *p = data;
+
+    for (size_t done = 0; done < bytes; ) {
+        ssize_t written = write(fd, p + done, bytes - done);
+        if (written < 0)
+            return 1;
+        done += written;
+    }
+
+    return padded > bytes && write(fd, zeros, padded - bytes) != (ssize_t)(padded - bytes);
+}
+
+
+static int write_snapshot(const struct game *game, const int fd)
+{
+    const struct world *world = game->world;
+    const struct entities *ent = game->ent;
+
+    struct snapshot_header header = {
+        .version = SNAPSHOT_VERSION, .byte_order = SNAPSHOT_BYTE_ORDER,
+        .world_size = world->size, .entities = ent->n, .cells = world->count, .chunks = world->chunk_count,
+        .seed = game->seed, .ticks = game->ticks, .kills = game->kills, .blobs_eaten = game->blobs_eaten,
+        .blobs = game->blobs, .alive = game->alive, .blobs_max = game->blobs_max,
+        .ai_cursor = game->ai.cursor, .ai_credit = game->ai.credit, .difficulty = game->difficulty
+    };
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    memcpy(header.rng, game->rng.s, sizeof(header.rng));
+
+    struct sections s;
+    sections(&s, world->chunk_count, world->count, ent->n);
+
+    if (write_all(fd, &header, sizeof(header), sizeof(header)))
+        return 1;
+
+    // allocated chunks are written straight from memory, index first
+    long chunks = (long)world->chunk_cols * world->chunk_cols;
+    for (long i=0; i < chunks; i++) {
+        if (world->chunks[i] == NULL)
+            continue;
+
+        int64_t index = i;
+        if (write_all(fd, &index, sizeof(index), offsetof(struct snapshot_chunk, chunk))
+            || write_all(fd, world->chunks[i], sizeof(struct chunk), sizeof(struct snapshot_chunk) - offsetof(struct snapshot_chunk, chunk)))
+            return 1;
+    }
+
+    // used slots of the side table, gathered in batches on the stack
+    struct snapshot_cell batch[CELLS_BATCH];
+    int batched = 0;
+    for (int i=0; i < world->capacity; i++) {
+        if (world->keys[i] == -1)
+            continue;
+
+        batch[batched++] = (struct snapshot_cell){ .pos = world->keys[i], .entity = world->values[i] };
+        if (batched == CELLS_BATCH) {
+            if (write_all(fd, batch, sizeof(batch), sizeof(batch)))
+                return 1;
+            batched = 0;
+        }
+    }
+    if (write_all(fd, batch, batched * sizeof(struct snapshot_cell), batched * sizeof(struct snapshot_cell)))
+        return 1;
+
+    const int *arrays[] = { ent->row, ent->col, ent->row_vector, ent->col_vector, ent->size, ent->color };
+    for (size_t i=0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+        if (write_all(fd, arrays[i], ent->n * sizeof(int), s.ints))
+            return 1;
+
+    return write_all(fd, ent->alive, ent->n * sizeof(bool), s.alive);
+}
+
+
+int snapshot_save(const struct game *game, const char *filename)
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return 1;
+
+    int failed = write_snapshot(game, fd);
+    failed |= close(fd) != 0;
+    return failed;
+}
+
+
+// chunk needs to be consistent with its own counts & bitmaps, cells outside of the world need to be EMPTY
+// @returns number of cells marked with ENTITY_CELL, -1 if the chunk is broken
+static int check_chunk(const struct chunk *chunk, const long index, const int chunk_cols, const int size)
+{
+    int top = (index / chunk_cols) * CHUNK, left = (index % chunk_cols) * CHUNK;
+    int used = 0, entities = 0;
+    int blobs[CHUNK_BUCKETS * CHUNK_BUCKETS] = {0};
+
+    for (int r=0; r < CHUNK; r++) {
+        uint64_t occupied = 0;
+        for (int c=0; c < CHUNK; c++) {
+            int cell = chunk->cells[r * CHUNK + c];
+            if (cell == EMPTY)
+                continue;
+            if ((cell >= ENTITY_START && cell != ENTITY_CELL) || top + r >= size || left + c >= size)
+                return -1;
+
+            occupied |= 1UL << c;
+            used++;
+            entities += cell == ENTITY_CELL;
+            blobs[(r / BLOB_CELL) * CHUNK_BUCKETS + c / BLOB_CELL] += cell != ENTITY_CELL;
+        }
+        if (occupied != chunk->occupied[r])
+            return -1;
+    }
+
+    for (int i=0; i < CHUNK_BUCKETS * CHUNK_BUCKETS; i++)
+        if (blobs[i] != chunk->blobs[i])
+            return -1;
+
+    // empty chunks are never allocated
+    return used == chunk->used && used > 0 ? entities : -1;
+}
+
+
+// checks every section of the snapshot before anything is copied into the game, so that a broken file is refused
+static int check(const struct snapshot_header *header, const char *data, const struct sections *s, const int chunk_cols)
+{
+    const long size = header->world_size;
+
+    // bots decide from the cursor onwards, it stays at the first bot when there are none
+    if (header->ai_cursor < PLAYERS || (header->ai_cursor >= header->entities && header->ai_cursor != PLAYERS))
+        return 1;
+
+    // negated comparisons refuse NaN too, only a fraction of a decision is carried over
+    if (!(header->ai_credit >= 0 && header->ai_credit < 1)
+        || !(header->difficulty >= (float) BOT_EASY && header->difficulty <= (float) BOT_HARD))
+        return 1;
+
+    long entity_cells = 0, blobs = 0;
+    for (long i=0; i < header->chunks; i++) {
+        const struct snapshot_chunk *chunk = (const struct snapshot_chunk *)(data + i * sizeof(struct snapshot_chunk));
+        if (chunk->index < 0 || chunk->index >= (long)chunk_cols * chunk_cols)
+            return 1;
+
+        int entities = check_chunk(&chunk->chunk, chunk->index, chunk_cols, size);
+        if (entities < 0)
+            return 1;
+        entity_cells += entities;
+        for (int b=0; b < CHUNK_BUCKETS * CHUNK_BUCKETS; b++)
+            blobs += chunk->chunk.blobs[b];
+    }
+    if (entity_cells != header->cells || blobs != header->blobs)
+        return 1;
+    data += s->chunks;
+
+    for (int i=0; i < header->cells; i++) {
+        struct snapshot_cell cell;
+        memcpy(&cell, data + i * sizeof(struct snapshot_cell), sizeof(cell));
+        if (cell.pos < 0 || cell.pos >= size * size || cell.entity < 0 || cell.entity >= header->entities)
+            return 1;
+    }
+    data += s->table;
+
+    // living entities need to be inside the world, they are put into the spatial index
+    // their radius can't outgrow the world, boxes around entities are searched every tick
+    const int *row = (const int *) data, *col = (const int *)(data + s->ints);
+    const int *row_vector = (const int *)(data + 2 * s->ints), *col_vector = (const int *)(data + 3 * s->ints);
+    const int *ent_size = (const int *)(data + 4 * s->ints), *color = (const int *)(data + 5 * s->ints);
+    const uint8_t *alive = (const uint8_t *)(data + 6 * s->ints);     // flags are read as bytes until they are checked
+    int living = 0;
+    for (int i=0; i < header->entities; i++) {
+        if (alive[i] > 1)
+            return 1;
+        if (alive[i] == 0)
+            continue;
+        if (row[i] < 0 || row[i] >= size || col[i] < 0 || col[i] >= size
+            || ent_size[i] <= 0 || ent_size[i] > size * SIZE_MODIFIER
+            || row_vector[i] < -VERTICAL_MODIFIER || row_vector[i] > VERTICAL_MODIFIER
+            || col_vector[i] < -HORIZONTAL_MODIFIER || col_vector[i] > HORIZONTAL_MODIFIER
+            || color[i] < ENTITY_COLORS_START || color[i] > ENTITY_COLORS_END)
+            return 1;
+        living++;
+    }
+
+    return living != header->alive;
+}
+
+
+// copies snapshot sections mapped in memory into the game
+static int restore(struct game *game, const struct snapshot_header *header, const char *data, const struct sections *s)
+{
+    struct world *world = game->world;
+    struct entities *ent = game->ent;
+
+    if (check(header, data, s, world->chunk_cols))
+        return 1;
+
+    // chunk indexes may still repeat, second copy is refused
+    for (long i=0; i < header->chunks; i++) {
+        const struct snapshot_chunk *chunk = (const struct snapshot_chunk *)(data + i * sizeof(struct snapshot_chunk));
+        if (world_chunk_load(world, chunk->index, &chunk->chunk))
+            return 1;
+    }
+    data += s->chunks;
+
+    // cells are already marked with ENTITY_CELL, so setting them only fills the side table
+    // repeated position would leave another ENTITY_CELL out of the table, it is found by the count
+    for (int i=0; i < header->cells; i++) {
+        struct snapshot_cell cell;
+        memcpy(&cell, data + i * sizeof(struct snapshot_cell), sizeof(cell));
+        // chunk is read directly, cell isn't in the side table yet
+        int row = cell.pos / world->size, col = cell.pos % world->size;
+        const struct chunk *chunk = world->chunks[(long)(row / CHUNK) * world->chunk_cols + col / CHUNK];
+        if (chunk == NULL || chunk->cells[(row % CHUNK) * CHUNK + col % CHUNK] != ENTITY_CELL)
+            return 1;
+        world_set(world, row, col, ENTITY_START + cell.entity);
+    }
+    if (world->count != header->cells)
+        return 1;
+    data += s->table;
+
+    int *arrays[] = { ent->row, ent->col, ent->row_vector, ent->col_vector, ent->size, ent->color };
+    for (size_t i=0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        memcpy(arrays[i], data, ent->n * sizeof(int));
+        data += s->ints;
+    }
+
+    // live list & spatial index are rebuilt in ascending order of entities, just like after game_reset()
+    const bool *alive = (const bool *) data;
+    entities_clear(ent);
+    spatial_clear(game->spatial);
+    for (int i=0; i < ent->n; i++)
+        if (alive[i]) {
+            entities_add(ent, i);
+            spatial_move(game->spatial, i, ent->row[i], ent->col[i]);
+        }
+
+    memcpy(game->rng.s, header->rng, sizeof(header->rng));
+    game->ticks = header->ticks;
+    game->kills = header->kills;
+    game->blobs_eaten = header->blobs_eaten;
+    game->blobs = header->blobs;
+    game->alive = header->alive;
+    game->ai.cursor = header->ai_cursor;
+    game->ai.credit = header->ai_credit;
+    game->difficulty = header->difficulty;
+    events_clear(game->events);
+    return 0;
+}
+
+
+struct game *snapshot_load(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct snapshot_header)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    const struct snapshot_header *header = map;
+    struct game *game = NULL;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 && header->version == SNAPSHOT_VERSION
+        && header->byte_order == SNAPSHOT_BYTE_ORDER
+        && header->world_size >= MIN_WORLD_SIZE && header->world_size <= MAX_WORLD_SIZE
+        && header->entities >= MIN_BOT_COUNT+PLAYERS && header->entities <= MAX_BOT_COUNT+PLAYERS
+        && header->cells >= 0 && header->cells <= header->entities)
+        game = game_create(header->world_size, header->entities - PLAYERS, header->seed);
+
+    // file needs to have exactly the sections the header describes
+    struct sections s;
+    if (game == NULL || header->chunks < 0 || header->chunks > (long)game->world->chunk_cols * game->world->chunk_cols
+        || sections(&s, header->chunks, header->cells, game->ent->n) != (size_t)st.st_size || header->blobs_max != game->blobs_max
+        || restore(game, header, (const char *) map + sizeof(struct snapshot_header), &s)) {
+        game_destroy(game);
+        game = NULL;
+    }
+
+    munmap(map, st.st_size);
+    return game;
+}
+
+
+int snapshot_checkpoint(const struct game *game, const char *filename, pid_t *pid)
+{
+    int failed = 0;
+
+    // the previous checkpoint is still being written
+    if (*pid > 0) {
+        int status;
+        pid_t done = waitpid(*pid, &status, WNOHANG);
+        if (done == 0)
+            return 0;
+
+        failed = done < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        *pid = 0;
+    }
+
+    // temporary file name is prepared before forking, child only makes system calls
+    char temporary[strlen(filename) + sizeof(SNAPSHOT_TEMPORARY)];
+    snprintf(temporary, sizeof(temporary), "%s" SNAPSHOT_TEMPORARY, filename);
+
+    pid_t child = fork();
+    if (child < 0)
+        return 1;
+
+    if (child == 0) {
+        int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int written = fd >= 0 && write_snapshot(game, fd) == 0;
+        written = fd >= 0 && close(fd) == 0 && written && rename(temporary, filename) == 0;
+        _exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    *pid = child;
+    return failed;
+}
+
+
+int snapshot_wait(pid_t *pid)
+{
+    if (*pid <= 0)
+        return 0;
+
+    int status;
+    pid_t done = waitpid(*pid, &status, 0);
+    *pid = 0;
+
+    return done < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
@@ -0,0 +1,104 @@
+// LIBRARY "snapshot.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "game.h"
+
+
+/**
+ * Header at the start of every snapshot file.
+ * Header is followed by sections copied straight from memory in native byte order, every section is padded to 8 bytes:
+ * allocated world chunks (struct snapshot_chunk), entity cells of the side table (struct snapshot_cell)
+ * & entity arrays (row, col, row_vector, col_vector, size, color & alive).
+ * Sizes of all sections follow from the header, so the file can be mapped & copied without parsing.
+ */
+struct snapshot_header {
+    char magic[4];              // SNAPSHOT_MAGIC
+    uint32_t version;           // SNAPSHOT_VERSION
+    uint32_t byte_order;        // SNAPSHOT_BYTE_ORDER as stored by the saving machine
+    int32_t world_size;         // dimensions of the world
+    int32_t entities;           // number of entities (player included)
+    int32_t cells;              // number of entity cells in the side table
+    int64_t chunks;             // number of allocated world chunks
+
+    uint64_t seed;              // seed the random generator was initialized with
+    uint64_t rng[4];            // state of the random generator
+    uint64_t ticks;             // game ticks since the start of the game
+    uint64_t kills;
+    uint64_t blobs_eaten;
+
+    int32_t blobs;
+    int32_t alive;
+    int32_t blobs_max;
+    int32_t ai_cursor;
+    float ai_credit;
+    float difficulty;
+};
+
+
+/**
+ * Allocated chunk of the world.
+ */
+struct snapshot_chunk {
+    int64_t index;              // row-major index of the chunk
+    struct chunk chunk;         // whole chunk as it is in memory
+};
+
+
+/**
+ * Entity cell of the world side table.
+ */
+struct snapshot_cell {
+    int64_t pos;                // row-major position of the cell
+    int32_t entity;             // entity index stored in the cell
+    int32_t unused;
+};
+
+
+/**
+ * Saves complete state of the game into a file.
+ * @param game game to save
+ * @param filename file to save into, it is overwritten
+ * @returns 0 if everything ok, 1 if file could not be written
+ */
+int snapshot_save(const struct game *game, const char *filename);
+
+
+/**
+ * Creates game from a snapshot file.
+ * File is mapped into memory & its sections are copied in bulk (chunk by chunk), only spatial index & live list are rebuilt from entities.
+ * Game continues exactly as the saved one would.
+ * @param filename snapshot file
+ * @returns pointer to the loaded game, NULL if file could not be read, isn't a snapshot of this version or memory could not be allocated
+ */
+struct game *snapshot_load(const char *filename);
+
+
+/**
+ * Saves snapshot in a forked child process, so the game continues right away.
+ * Child sees memory of the game at the time of the fork (copy-on-write) & writes it into a temporary file,
+ * which replaces the checkpoint only when it is complete.
+ * Checkpoint is skipped while the previous one is still being written.
+ * @param game game to save
+ * @param filename checkpoint file
+ * @param pid pointer to process id of the running checkpoint (0 when there is none), updated by this function
+ * @returns 0 if checkpoint was started or skipped, 1 if the previous checkpoint failed or process could not be forked
+ */
+int snapshot_checkpoint(const struct game *game, const char *filename, pid_t *pid);
+
+
+/**
+ * Waits until the running checkpoint is written.
+ * @param pid pointer to process id of the running checkpoint (0 when there is none), reset to 0
+ * @returns 0 if everything ok, 1 if checkpoint could not be written
+ */
+int snapshot_wait(pid_t *pid);
+
+
+#endif
@@ -0,0 +1,162 @@
+// IMPLEMENTATION of library "spatial.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "spatial.h"
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// squared distance of entity from point
+static inline long dist2(const struct spatial *spatial, const int i, const int row, const int col)
+{
+    long dr = spatial->row[i] - row;
+    long dc = spatial->col[i] - col;
+    return dr*dr + dc*dc;
+}
+
+
+struct spatial *spatial_create(const int world_size, const int n)
+{
+    struct spatial *spatial = calloc(1, sizeof(struct spatial));
+    if (spatial == NULL)
+        return NULL;
+
+    spatial->n = n;
+    spatial->cols = (world_size + SPATIAL_CELL - 1) / SPATIAL_CELL;
+    spatial->head = malloc((size_t)spatial->cols * spatial->cols * sizeof(int));
+    spatial->next = malloc(n * sizeof(int));
+    spatial->prev = malloc(n * sizeof(int));
+    spatial->bucket = malloc(n * sizeof(int));
+    spatial->row = malloc(n * sizeof(int));
+    spatial->col = malloc(n * sizeof(int));
+
+    if (spatial->head == NULL || spatial->next == NULL || spatial->prev == NULL
+        || spatial->bucket == NULL || spatial->row == NULL || spatial->col == NULL) {
+        spatial_destroy(spatial);
+        return NULL;
+    }
+
+    spatial_clear(spatial);
+    return spatial;
+}
+
+
+void spatial_clear(struct spatial *spatial)
+{
+    memset(spatial->head, -1, (size_t)spatial->cols * spatial->cols * sizeof(int));    // all bytes set -> -1
+    memset(spatial->bucket, -1, spatial->n * sizeof(int));
+}
+
+
+void spatial_destroy(struct spatial *spatial)
+{
+    if (spatial == NULL)
+        return;
+
+    free(spatial->head);
+    free(spatial->next);
+    free(spatial->prev);
+    free(spatial->bucket);
+    free(spatial->row);
+    free(spatial->col);
+    free(spatial);
+}
+
+
+void spatial_remove(struct spatial *spatial, const int i)
+{
+    int b = spatial->bucket[i];
+    if (b == -1)
+        return;
+
+    // unlink from bucket's list
+    if (spatial->prev[i] != -1)
+        spatial->next[spatial->prev[i]] = spatial->next[i];
+    else
+        spatial->head[b] = spatial->next[i];
+
+    if (spatial->next[i] != -1)
+        spatial->prev[spatial->next[i]] = spatial->prev[i];
+
+    spatial->bucket[i] = -1;
+}
+
+
+void spatial_move(struct spatial *spatial, const int i, const int row, const int col)
+{
+    int b = (row / SPATIAL_CELL) * spatial->cols + col / SPATIAL_CELL;
+
+    spatial->row[i] = row;
+    spatial->col[i] = col;
+
+    if (spatial->bucket[i] == b)
+        return;
+
+    spatial_remove(spatial, i);
+
+    // link at the beginning of new bucket's list
+    spatial->prev[i] = -1;
+    spatial->next[i] = spatial->head[b];
+    if (spatial->head[b] != -1)
+        spatial->prev[spatial->head[b]] = i;
+    spatial->head[b] = i;
+    spatial->bucket[i] = b;
+}
+
+
+int spatial_nearest(const struct spatial *spatial, const int row, const int col, const float radius, const int k, int out[k])
+{
+    if (k <= 0)
+        return 0;
+
+    int b_row = row / SPATIAL_CELL;
+    int b_col = col / SPATIAL_CELL;
+    float limit = radius * radius;
+    int count = 0;
+
+    // expand square rings of buckets around the query point
+    for (int ring=0; ring < spatial->cols; ring++) {
+        // every bucket in this ring is at least (ring-1) * SPATIAL_CELL + 1 away from the query point
+        long reach = (long)(ring-1) * SPATIAL_CELL + 1;
+        if (ring > 0 && reach*reach > limit)
+            break;
+        if (count == k && ring > 0 && reach*reach > dist2(spatial, out[k-1], row, col))
+            break;
+
+        for (int i=b_row-ring; i <= b_row+ring; i++) {
+            if (i < 0 || i >= spatial->cols)
+                continue;
+
+            // inner rows of the ring contain only 2 buckets on the sides
+            int step = (i == b_row-ring || i == b_row+ring) ? 1 : 2*ring;
+            for (int ii=b_col-ring; ii <= b_col+ring; ii += step > 0 ? step : 1) {
+                if (ii < 0 || ii >= spatial->cols)
+                    continue;
+
+                for (int e = spatial->head[i * spatial->cols + ii]; e != -1; e = spatial->next[e]) {
+                    long d = dist2(spatial, e, row, col);
+                    if (d > limit)
+                        continue;
+
+                    // insertion into sorted buffer (by distance, then by index)
+                    int j = count < k ? count++ : k;
+                    while (j > 0) {
+                        long prev = dist2(spatial, out[j-1], row, col);
+                        if (prev < d || (prev == d && out[j-1] < e))
+                            break;
+                        if (j < k)
+                            out[j] = out[j-1];
+                        j--;
+                    }
+                    if (j < k)
+                        out[j] = e;
+                }
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,80 @@
+// LIBRARY "spatial.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+
+/**
+ * Uniform grid of buckets used as broad-phase index of entities.
+ * World is divided into SPATIAL_CELL x SPATIAL_CELL buckets, each bucket holds intrusive
+ * doubly linked list of entity indexes, so moving entity between buckets is O(1).
+ */
+struct spatial {
+    int n;              // maximum number of indexed entities
+    int cols;           // number of buckets in one row (grid is square)
+    int *head;          // first entity in each bucket, -1 if bucket is empty
+    int *next;          // next entity in the same bucket, -1 at the end
+    int *prev;          // previous entity in the same bucket, -1 at the beginning
+    int *bucket;        // bucket of each entity, -1 if entity isn't indexed
+    int *row;           // last known 'y' coordinate of each entity
+    int *col;           // last known 'x' coordinate of each entity
+};
+
+
+/**
+ * Allocates empty spatial index.
+ * @param world_size dimensions of the indexed world
+ * @param n maximum number of entities
+ * @returns pointer to the allocated index, NULL if memory could not be allocated
+ */
+struct spatial *spatial_create(const int world_size, const int n);
+
+
+/**
+ * Removes every entity from the index.
+ * @param spatial index to clear
+ */
+void spatial_clear(struct spatial *spatial);
+
+
+/**
+ * Frees spatial index.
+ * @param spatial index to free (NULL is allowed)
+ */
+void spatial_destroy(struct spatial *spatial);
+
+
+/**
+ * Adds entity to the index, or moves it when it is already indexed.
+ * Entity is relinked only when it crosses bucket boundary.
+ * @attention row & col need to be inside the world bounds
+ * @param i entity index
+ * @param row 'y' coordinate of entity
+ * @param col 'x' coordinate of entity
+ */
+void spatial_move(struct spatial *spatial, const int i, const int row, const int col);
+
+
+/**
+ * Removes entity from the index (entity which isn't indexed is ignored).
+ * @param i entity index
+ */
+void spatial_remove(struct spatial *spatial, const int i);
+
+
+/**
+ * Finds k nearest entities within the given distance, ordered from the nearest one.
+ * Entities in the same distance are ordered by their index.
+ * @param row 'y' coordinate of query point
+ * @param col 'x' coordinate of query point
+ * @param radius maximum distance of found entity centre
+ * @param k maximum number of entities to find (capacity of out buffer)
+ * @param out buffer for found entity indexes
+ * @returns number of entities stored in out
+ */
+int spatial_nearest(const struct spatial *spatial, const int row, const int col, const float radius, const int k, int out[k]);
+
+
+#endif
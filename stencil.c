@@ -0,0 +1,106 @@
+// IMPLEMENTATION of library "stencil.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "stencil.h"
+#include "config.h"
+
+#include <stdlib.h>
+
+
+// cache indexed by doubled radius
+static struct stencil **cache = NULL;
+static int cache_len = 0;
+
+
+// builds stencil for radius = h / 2, every distance test is done with squared integers
+static struct stencil *build(const int h)
+{
+    // get bigger of the two modifiers to account for that in hitboxes (to prevent jumping over the hitbox)
+    int modiff = HORIZONTAL_MODIFIER > VERTICAL_MODIFIER ? HORIZONTAL_MODIFIER : VERTICAL_MODIFIER;
+    modiff -= 1;    // base modifier starts at 1
+
+    int rows = h / 2;
+    long outer = (long)h * h;                       // (2 * radius)^2
+    long inner_h = h - 2 * (modiff + 1);            // 2 * (radius - modiff - 1)
+    long inner = inner_h > 0 ? inner_h * inner_h : 0;
+
+    // count ring cells first, so that everything fits into one allocation
+    int ring_count = 0;
+    for (int i=-rows; i <= rows; i++)
+        for (int ii=-rows; ii <= rows; ii++) {
+            long d = 4L * (i*i + ii*ii);
+            if (d >= inner && d <= outer)
+                ring_count++;
+        }
+
+    int ints = (2*rows + 1) + 2 * ring_count;
+    struct stencil *stencil = malloc(sizeof(struct stencil) + ints * sizeof(int));
+    if (stencil == NULL)
+        return NULL;
+
+    int *data = (int *)(stencil + 1);
+    stencil->rows = rows;
+    stencil->span = data;
+    stencil->ring_count = ring_count;
+    stencil->ring_row = data + 2*rows + 1;
+    stencil->ring_col = stencil->ring_row + ring_count;
+
+    int r = 0;
+    for (int i=-rows; i <= rows; i++) {
+        int span = 0;
+        for (int ii=-rows; ii <= rows; ii++) {
+            long d = 4L * (i*i + ii*ii);
+            if (d <= outer && ii > span)
+                span = ii;
+
+            if (d >= inner && d <= outer) {
+                stencil->ring_row[r] = i;
+                stencil->ring_col[r] = ii;
+                r++;
+            }
+        }
+        stencil->span[i + rows] = span;
+    }
+
+    return stencil;
+}
+
+
+const struct stencil *stencil_get(const float radius)
+{
+    int h = radius * 2;
+    if (h < 0)
+        h = 0;
+
+    if (h >= cache_len) {
+        int len = cache_len > 0 ? cache_len : 16;
+        while (len <= h)
+            len *= 2;
+
+        struct stencil **grown = realloc(cache, len * sizeof(struct stencil *));
+        if (grown == NULL)
+            return NULL;
+
+        for (int i=cache_len; i < len; i++)
+            grown[i] = NULL;
+        cache = grown;
+        cache_len = len;
+    }
+
+    if (cache[h] == NULL)
+        cache[h] = build(h);
+
+    return cache[h];
+}
+
+
+void stencil_free(void)
+{
+    for (int i=0; i < cache_len; i++)
+        free(cache[i]);
+
+    free(cache);
+    cache = NULL;
+    cache_len = 0;
+}
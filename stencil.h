@@ -0,0 +1,39 @@
+// LIBRARY "stencil.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef STENCIL_H
+#define STENCIL_H
+
+
+/**
+ * Precomputed cell offsets of a circle with given radius.
+ * Radii of entities are quantized (see get_radius()), so stencils are built once per radius & cached.
+ */
+struct stencil {
+    int rows;           // number of rows above/below the centre covered by the circle
+    int *span;          // half-width of filled row at row offset i is span[i + rows]
+
+    // offsets along the circumference (thickened by the bigger movement modifier), in row-major order
+    int ring_count;
+    int *ring_row;
+    int *ring_col;
+};
+
+
+/**
+ * Gets stencil of circle with given radius, stencil is built on the first request.
+ * @attention radius needs to be a multiple of 0.5
+ * @param radius radius of a circle
+ * @returns pointer to the cached stencil, NULL if memory could not be allocated
+ */
+const struct stencil *stencil_get(const float radius);
+
+
+/**
+ * Frees every cached stencil.
+ */
+void stencil_free(void);
+
+
+#endif
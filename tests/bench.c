@@ -0,0 +1,179 @@
+// BENCHMARK of the simulation core "game.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+// Measures core functions on several world sizes & bot counts without curses.
+// Every result is printed as a single JSON object per line, eg.
+// {"bench":"eval_positions","world":1200,"bots":1000,"ops":120,"ns_per_op":81234.5}
+// so results of two runs can be compared by a script to catch regressions.
+// Parallel evaluation runs on all online CPUs unless number of threads is given: ./tests/bench [THREADS]
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "game.h"
+#include "stencil.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_SEED 42               // every configuration starts from the same game
+#define BENCH_OPS 100000            // calls of cheap functions (collision check & spawning)
+#define BENCH_TICKS 200             // maximum number of measured ticks
+#define BENCH_TIME 1000000000L      // maximum time spent on ticks of one configuration (ns)
+
+
+static const int world_sizes[] = { 100, 1200, 10000 };
+static const int bot_counts[] = { 0, 1000, 100000 };
+
+
+static void report(const char *bench, const struct game *game, const int bots, const long ops, const long ns)
+{
+    printf("{\"bench\":\"%s\",\"world\":%d,\"bots\":%d,\"ops\":%ld,\"ns_per_op\":%.1f}\n",
+        bench, game->world->size, bots, ops, ops > 0 ? (double) ns / ops : 0);
+}
+
+
+static void bench_collision(struct game *game, const int bots, struct rng *rng)
+{
+    int size = game->world->size;
+    int hits = 0;
+
+    long start = profile_now();
+    for (long i=0; i < BENCH_OPS; i++) {
+        int radius = rng_int(rng, MIN_BASE_RADIUS, MAX_BASE_RADIUS);
+        int row = rng_int(rng, radius, (size-1)-radius);
+        int col = rng_int(rng, radius, (size-1)-radius);
+        hits += check_collision(row, col, radius, game->world);
+    }
+    report("check_collision", game, bots, BENCH_OPS, profile_now() - start);
+
+    if (hits < 0)   // keeps the calls from being optimized out
+        printf("%d\n", hits);
+}
+
+
+static void bench_entity_spawn(struct game *game, const int bots)
+{
+    int row, col;
+
+    long start = profile_now();
+    for (long i=0; i < BENCH_OPS; i++)
+        entity_spawn(&row, &col, game->world, &game->rng);
+    report("entity_spawn", game, bots, BENCH_OPS, profile_now() - start);
+}
+
+
+// blobs are really spawned, so this needs to run after every other measurement of the configuration
+static void bench_blob_spawn(struct game *game, const int bots)
+{
+    long start = profile_now();
+    for (long i=0; i < BENCH_OPS; i++) {
+        blob_spawn(0, 1, 1, game->world, &game->rng, game->events);      // never full, so every call tries to spawn
+        events_clear(game->events);
+    }
+    report("blob_spawn", game, bots, BENCH_OPS, profile_now() - start);
+}
+
+
+// runs phases of game_tick() one by one, so each of them is measured separately
+static void bench_ticks(struct game *game, const int bots)
+{
+    long vectors = 0, positions = 0, eval = 0;
+    long ticks = 0;
+
+    long start = profile_now();
+    while (ticks < BENCH_TICKS && profile_now() - start < BENCH_TIME) {
+        long t0 = profile_now();
+        update_bot_vectors(game->ent, &game->ai, game->spatial, game->world, game->difficulty, &game->rng);
+        long t1 = profile_now();
+        game->blobs -= update_positions(game->ent, game->world, game->spatial);
+        long t2 = profile_now();
+        eval_positions(game->ent, game->world, game->spatial, game->events, game->near);
+        long t3 = profile_now();
+        game_events(game);
+        events_clear(game->events);
+
+        vectors += t1 - t0;
+        positions += t2 - t1;
+        eval += t3 - t2;
+        ticks++;
+    }
+    long total = profile_now() - start;
+
+    report("update_bot_vectors", game, bots, ticks, vectors);
+    report("update_positions", game, bots, ticks, positions);
+    report("eval_positions", game, bots, ticks, eval);
+    printf("{\"bench\":\"tick\",\"world\":%d,\"bots\":%d,\"ops\":%ld,\"ns_per_op\":%.1f,\"ticks_per_sec\":%.1f,\"alive\":%d}\n",
+        game->world->size, bots, ticks, ticks > 0 ? (double) total / ticks : 0, total > 0 ? ticks * 1e9 / total : 0, game->alive);
+}
+
+
+// same ticks as bench_ticks() with collisions evaluated on multiple threads
+static void bench_parallel(struct game *game, const int bots, const int threads)
+{
+    long eval = 0;
+    long ticks = 0;
+
+    long start = profile_now();
+    while (ticks < BENCH_TICKS && profile_now() - start < BENCH_TIME) {
+        update_bot_vectors(game->ent, &game->ai, game->spatial, game->world, game->difficulty, &game->rng);
+        game->blobs -= update_positions(game->ent, game->world, game->spatial);
+        long t0 = profile_now();
+        eval_positions_parallel(game->ent, game->world, game->spatial, game->events, game->near, game->pool, game->gather);
+        eval += profile_now() - t0;
+        game_events(game);
+        events_clear(game->events);
+        ticks++;
+    }
+    long total = profile_now() - start;
+
+    printf("{\"bench\":\"eval_positions_parallel\",\"world\":%d,\"bots\":%d,\"threads\":%d,\"ops\":%ld,\"ns_per_op\":%.1f}\n",
+        game->world->size, bots, threads, ticks, ticks > 0 ? (double) eval / ticks : 0);
+    printf("{\"bench\":\"tick_parallel\",\"world\":%d,\"bots\":%d,\"threads\":%d,\"ops\":%ld,\"ns_per_op\":%.1f,\"ticks_per_sec\":%.1f,\"alive\":%d}\n",
+        game->world->size, bots, threads, ticks, ticks > 0 ? (double) total / ticks : 0, total > 0 ? ticks * 1e9 / total : 0, game->alive);
+}
+
+
+int main(int argc, char *argv[])
+{
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (argc > 1)
+        sscanf(argv[1], "%d", &threads);
+
+    for (size_t w=0; w < sizeof(world_sizes) / sizeof(world_sizes[0]); w++)
+        for (size_t b=0; b < sizeof(bot_counts) / sizeof(bot_counts[0]); b++) {
+            int bots = bot_counts[b];
+
+            struct game *game = game_create(world_sizes[w], bots, BENCH_SEED);
+            if (game == NULL) {
+                fprintf(stderr, "Not enough memory to create the world (%d, %d).\n", world_sizes[w], bots);
+                return EXIT_FAILURE;
+            }
+
+            long start = profile_now();
+            game_reset(game);
+            report("game_reset", game, bots, 1, profile_now() - start);
+
+            struct rng rng;
+            rng_seed(&rng, BENCH_SEED);
+
+            bench_collision(game, bots, &rng);
+            bench_entity_spawn(game, bots);
+            bench_ticks(game, bots);
+            bench_blob_spawn(game, bots);
+
+            // parallel ticks start from the same game as serial ones
+            if (threads > 1 && game_threads(game, threads) == 0) {
+                game_reset(game);
+                bench_parallel(game, bots, threads);
+            }
+
+            game_destroy(game);
+            fflush(stdout);
+        }
+
+    stencil_free();
+    return EXIT_SUCCESS;
+}
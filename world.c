@@ -0,0 +1,426 @@
+// IMPLEMENTATION of library "world.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#include "world.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TABLE_MIN_CAPACITY 64
+
+// occupancy bitmap of a chunk has a single word per row
+_Static_assert(CHUNK == 64 && CHUNK % BLOB_CELL == 0, "chunk rows need to fit a 64-bit word & whole blob buckets");
+
+
+// fibonacci hashing of cell position into side table slot
+static inline int slot(const struct world *world, const long pos)
+{
+    return (int)(((unsigned long)pos * 0x9E3779B97F4A7C15UL) >> 32) & (world->capacity - 1);
+}
+
+
+// allocates empty side table with given capacity, old table is freed on success
+static int table_alloc(struct world *world, const int capacity)
+{
+    long *keys = malloc(capacity * sizeof(long));
+    int *values = malloc(capacity * sizeof(int));
+    if (keys == NULL || values == NULL) {
+        free(keys);
+        free(values);
+        return 1;
+    }
+
+    memset(keys, -1, capacity * sizeof(long));      // all bytes set -> -1
+
+    free(world->keys);
+    free(world->values);
+    world->keys = keys;
+    world->values = values;
+    world->capacity = capacity;
+    world->count = 0;
+    return 0;
+}
+
+
+static void table_insert(struct world *world, const long pos, const int index)
+{
+    // keep load factor under 1/2, so that probing sequences stay short
+    if (2 * (world->count + 1) > world->capacity) {
+        long *keys = world->keys;
+        int *values = world->values;
+        int capacity = world->capacity;
+
+        world->keys = NULL;
+        world->values = NULL;
+        if (table_alloc(world, 2 * capacity)) {
+            // out of memory - keep using the old table, it still has free slots
+            world->keys = keys;
+            world->values = values;
+        } else {
+            for (int i=0; i < capacity; i++)
+                if (keys[i] != -1)
+                    table_insert(world, keys[i], values[i]);
+            free(keys);
+            free(values);
+        }
+    }
+
+    int i = slot(world, pos);
+    while (world->keys[i] != -1 && world->keys[i] != pos)
+        i = (i + 1) & (world->capacity - 1);
+
+    if (world->keys[i] == -1)
+        world->count++;
+
+    world->keys[i] = pos;
+    world->values[i] = index;
+}
+
+
+static void table_remove(struct world *world, const long pos)
+{
+    int mask = world->capacity - 1;
+    int i = slot(world, pos);
+    while (world->keys[i] != pos)
+        i = (i + 1) & mask;
+
+    // backward shift deletion - move following entries of the probing sequence into the hole
+    int hole = i;
+    for (int j = (hole + 1) & mask; world->keys[j] != -1; j = (j + 1) & mask) {
+        int home = slot(world, world->keys[j]);
+
+        // entry can be moved only if its home slot isn't cyclically between the hole and its slot
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            world->keys[hole] = world->keys[j];
+            world->values[hole] = world->values[j];
+            hole = j;
+        }
+    }
+    world->keys[hole] = -1;
+    world->count--;
+}
+
+
+// rows (or cols) of the world covered by the given row (or col) of chunks, the last one can be smaller
+static inline int chunk_side(const struct world *world, const int i)
+{
+    return i < world->chunk_cols-1 ? CHUNK : world->size - i * CHUNK;
+}
+
+
+// resets free counts of an empty world
+static void free_clear(struct world *world)
+{
+    for (int i=0; i < world->chunk_cols; i++)
+        world->free_rows[i] = (long)chunk_side(world, i) * world->size;
+    world->free_total = (long)world->size * world->size;
+}
+
+
+struct world *world_create(const int size)
+{
+    struct world *world = calloc(1, sizeof(struct world));
+    if (world == NULL)
+        return NULL;
+
+    // every chunk starts missing (EMPTY), they are allocated when something is written into them
+    world->size = size;
+    world->chunk_cols = (size + CHUNK - 1) / CHUNK;
+    world->chunks = calloc((size_t)world->chunk_cols * world->chunk_cols, sizeof(struct chunk *));
+    world->free_rows = malloc(world->chunk_cols * sizeof(long));
+    if (world->chunks == NULL || world->free_rows == NULL || table_alloc(world, TABLE_MIN_CAPACITY)) {
+        world_destroy(world);
+        return NULL;
+    }
+
+    free_clear(world);
+    return world;
+}
+
+
+// chunks of the world freed by a single worker
+struct clear {
+    struct world *world;
+    int threads;
+};
+
+
+static void clear_job(void *arg, const int worker)
+{
+    const struct clear *job = arg;
+    struct world *world = job->world;
+    long chunks = (long)world->chunk_cols * world->chunk_cols;
+    long first = chunks * worker / job->threads;
+    long last = chunks * (worker+1) / job->threads;
+
+    for (long i=first; i < last; i++) {
+        free(world->chunks[i]);
+        world->chunks[i] = NULL;
+    }
+}
+
+
+int world_reset(struct world *world, const int size, struct pool *pool)
+{
+    if (size != world->size) {
+        int chunk_cols = (size + CHUNK - 1) / CHUNK;
+        struct chunk **chunks = calloc((size_t)chunk_cols * chunk_cols, sizeof(struct chunk *));
+        long *free_rows = malloc(chunk_cols * sizeof(long));
+        if (chunks == NULL || free_rows == NULL) {
+            free(chunks);
+            free(free_rows);
+            return 1;
+        }
+
+        struct clear job = { .world = world, .threads = 1 };
+        clear_job(&job, 0);
+        free(world->chunks);
+        free(world->free_rows);
+        world->chunks = chunks;
+        world->free_rows = free_rows;
+        world->chunk_cols = chunk_cols;
+        world->size = size;
+    } else {
+        struct clear job = { .world = world, .threads = pool != NULL ? pool->threads : 1 };
+        if (pool != NULL)
+            pool_run(pool, clear_job, &job);
+        else
+            clear_job(&job, 0);
+    }
+    world->chunk_count = 0;
+    free_clear(world);
+
+    memset(world->keys, -1, world->capacity * sizeof(long));
+    world->count = 0;
+    return 0;
+}
+
+
+void world_destroy(struct world *world)
+{
+    if (world == NULL)
+        return;
+
+    if (world->chunks != NULL) {
+        struct clear job = { .world = world, .threads = 1 };
+        clear_job(&job, 0);
+    }
+    free(world->chunks);
+    free(world->free_rows);
+    free(world->keys);
+    free(world->values);
+    free(world);
+}
+
+
+int world_entity(const struct world *world, const long pos)
+{
+    int i = slot(world, pos);
+    while (world->keys[i] != pos)
+        i = (i + 1) & (world->capacity - 1);
+
+    return world->values[i];
+}
+
+
+void world_set(struct world *world, const int row, const int col, const int value)
+{
+    long pos = (long)row * world->size + col;
+    long index = (long)(row / CHUNK) * world->chunk_cols + col / CHUNK;
+    struct chunk *chunk = world->chunks[index];
+    int cell = (row % CHUNK) * CHUNK + col % CHUNK;
+    int old = chunk != NULL ? chunk->cells[cell] : EMPTY;
+
+    if (old == ENTITY_CELL && value < ENTITY_START)
+        table_remove(world, pos);
+
+    // missing chunk stays missing
+    if (old == EMPTY && value == EMPTY)
+        return;
+
+    if (chunk == NULL) {
+        chunk = calloc(1, sizeof(struct chunk));
+        if (chunk == NULL) {
+            fprintf(stderr, "Not enough memory to grow the world.\n");
+            exit(EXIT_FAILURE);
+        }
+        world->chunks[index] = chunk;
+        world->chunk_count++;
+    }
+
+    // blob & free counts
+    int bucket = ((row % CHUNK) / BLOB_CELL) * CHUNK_BUCKETS + (col % CHUNK) / BLOB_CELL;
+    bool was_blob = old >= BLOB_START && old < ENTITY_START;
+    bool is_blob = value >= BLOB_START && value < ENTITY_START;
+    if (was_blob != is_blob)
+        chunk->blobs[bucket] += is_blob ? 1 : -1;
+
+    if ((old == EMPTY) != (value == EMPTY)) {
+        int change = value == EMPTY ? 1 : -1;
+        chunk->used -= change;
+        world->free_rows[row / CHUNK] += change;
+        world->free_total += change;
+
+        // occupancy bit of the cell
+        chunk->occupied[row % CHUNK] ^= 1UL << (col % CHUNK);
+    }
+
+    if (value >= ENTITY_START) {
+        table_insert(world, pos, value - ENTITY_START);
+        chunk->cells[cell] = ENTITY_CELL;
+    } else {
+        chunk->cells[cell] = value;
+    }
+
+    // chunk emptied out
+    if (chunk->used == 0) {
+        free(chunk);
+        world->chunks[index] = NULL;
+        world->chunk_count--;
+    }
+}
+
+
+int world_chunk_load(struct world *world, const long index, const struct chunk *chunk)
+{
+    struct chunk *copy = world->chunks[index] == NULL ? malloc(sizeof(struct chunk)) : NULL;
+    if (copy == NULL)
+        return 1;
+
+    memcpy(copy, chunk, sizeof(struct chunk));
+    world->chunks[index] = copy;
+    world->chunk_count++;
+
+    world->free_rows[index / world->chunk_cols] -= copy->used;
+    world->free_total -= copy->used;
+    return 0;
+}
+
+
+bool world_box_empty(const struct world *world, const int top, const int left, const int bottom, const int right)
+{
+    for (int i = top / CHUNK; i <= bottom / CHUNK; i++) {
+        int first = (i == top / CHUNK ? top : i * CHUNK) % CHUNK;
+        int last = (i == bottom / CHUNK ? bottom : i * CHUNK + CHUNK-1) % CHUNK;
+
+        for (int ii = left / CHUNK; ii <= right / CHUNK; ii++) {
+            const struct chunk *chunk = world->chunks[(long)i * world->chunk_cols + ii];
+            if (chunk == NULL)
+                continue;
+
+            uint64_t mask = ~0UL;
+            if (ii == left / CHUNK)
+                mask &= ~0UL << (left % CHUNK);
+            if (ii == right / CHUNK)
+                mask &= ~0UL >> (CHUNK-1 - right % CHUNK);
+
+            // rows of the chunk are or-ed together, so the loop has no branches
+            uint64_t bits = 0;
+            for (int r=first; r <= last; r++)
+                bits |= chunk->occupied[r];
+            if (bits & mask)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool world_nearest_blob(const struct world *world, const int row, const int col, const float radius, int *blob_row, int *blob_col)
+{
+    int buckets = (world->size + BLOB_CELL - 1) / BLOB_CELL;
+    int b_row = row / BLOB_CELL;
+    int b_col = col / BLOB_CELL;
+    long best = radius * radius;
+    bool found = false;
+
+    // expand square rings of buckets around the query point
+    for (int ring=0; ring < buckets; ring++) {
+        // every bucket in this ring is at least (ring-1) * BLOB_CELL + 1 away from the query point
+        long reach = (long)(ring-1) * BLOB_CELL + 1;
+        if (ring > 0 && reach*reach > best)
+            break;
+
+        for (int i=b_row-ring; i <= b_row+ring; i++) {
+            if (i < 0 || i >= buckets)
+                continue;
+
+            // inner rows of the ring contain only 2 buckets on the sides
+            int step = (i == b_row-ring || i == b_row+ring) ? 1 : 2*ring;
+            for (int ii=b_col-ring; ii <= b_col+ring; ii += step > 0 ? step : 1) {
+                if (ii < 0 || ii >= buckets)
+                    continue;
+
+                const struct chunk *chunk = world->chunks[(long)(i / CHUNK_BUCKETS) * world->chunk_cols + ii / CHUNK_BUCKETS];
+                if (chunk == NULL || chunk->blobs[(i % CHUNK_BUCKETS) * CHUNK_BUCKETS + ii % CHUNK_BUCKETS] == 0)
+                    continue;
+
+                // scan cells of the bucket, a tie is won by the blob found first - rings go from the inside out,
+                // buckets of a ring & cells of a bucket are scanned in row-major order
+                for (int r = i * BLOB_CELL; r < (i+1) * BLOB_CELL && r < world->size; r++)
+                    for (int c = ii * BLOB_CELL; c < (ii+1) * BLOB_CELL && c < world->size; c++) {
+                        int cell = chunk->cells[(r % CHUNK) * CHUNK + c % CHUNK];
+                        if (cell < BLOB_START || cell >= ENTITY_START)
+                            continue;
+
+                        long d = (long)(r-row)*(r-row) + (long)(c-col)*(c-col);
+                        if (d < best || (!found && d == best)) {
+                            best = d;
+                            found = true;
+                            *blob_row = r;
+                            *blob_col = c;
+                        }
+                    }
+            }
+        }
+    }
+
+    return found;
+}
+
+
+bool world_free_cell(const struct world *world, long index, int *row, int *col)
+{
+    if (index < 0 || index >= world->free_total)
+        return false;
+
+    // row of chunks, then chunk in the row
+    int i = 0;
+    while (index >= world->free_rows[i])
+        index -= world->free_rows[i++];
+
+    int rows = chunk_side(world, i);
+    const struct chunk *chunk;
+    int ii = 0;
+    for (;; ii++) {
+        chunk = world->chunks[(long)i * world->chunk_cols + ii];
+        long free_cells = (long)rows * chunk_side(world, ii) - (chunk != NULL ? chunk->used : 0);
+        if (index < free_cells)
+            break;
+        index -= free_cells;
+    }
+
+    // row of the chunk by counting its occupancy bits, then free cell in the row
+    int cols = chunk_side(world, ii);
+    uint64_t mask = cols < CHUNK ? (1UL << cols) - 1 : ~0UL;
+    for (int r=0; r < rows; r++) {
+        uint64_t free_bits = ~(chunk != NULL ? chunk->occupied[r] : 0) & mask;
+        int free_cells = __builtin_popcountl(free_bits);
+        if (index >= free_cells) {
+            index -= free_cells;
+            continue;
+        }
+
+        while (index-- > 0)
+            free_bits &= free_bits - 1;     // clears the lowest free bit
+
+        *row = i * CHUNK + r;
+        *col = ii * CHUNK + __builtin_ctzl(free_bits);
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,165 @@
+// LIBRARY "world.h"
+// AUTHOR: KRISTIAN KORIBSKY
+// DATE: 8.12.2022
+// ==========================================================================
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "config.h"
+#include "pool.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// blob buckets in one row of a chunk
+#define CHUNK_BUCKETS (CHUNK / BLOB_CELL)
+
+
+/**
+ * Square part of the world with CHUNK x CHUNK cells.
+ * Chunk is allocated on the first write of a cell that isn't EMPTY & freed when all of its cells are EMPTY again.
+ */
+struct chunk {
+    uint8_t cells[CHUNK * CHUNK];       // row-major cells of the chunk
+    uint64_t occupied[CHUNK];           // occupancy bitmap, a single word per row, bit of every cell that is not EMPTY is set
+    int used;                           // cells that are not EMPTY
+    uint16_t blobs[CHUNK_BUCKETS * CHUNK_BUCKETS];  // blobs in every BLOB_CELL x BLOB_CELL bucket of the chunk
+};
+
+
+/**
+ * Square map of a world containing blob colors & entity indexes.
+ * Every cell takes a single byte: EMPTY or blob color is stored directly, cells holding an entity
+ * are marked with ENTITY_CELL and their entity index is kept in a small side table keyed by cell position.
+ * Cells are stored in chunks allocated lazily, so memory of the world grows with its content, not with its size.
+ * Missing chunk is all EMPTY.
+ */
+struct world {
+    int size;           // dimensions of the world (size x size)
+    int chunk_cols;     // chunks in one row of the world
+    struct chunk **chunks;  // chunk_cols * chunk_cols chunks, row-major, NULL when chunk is empty
+    long chunk_count;   // allocated chunks
+
+    // side table (open addressing hash map) of cells marked with ENTITY_CELL
+    long *keys;         // cell position, -1 when slot is free
+    int *values;        // entity index stored at the given cell position
+    int capacity;       // number of slots, always power of 2
+    int count;          // number of used slots
+
+    // EMPTY cells kept in sync by world_set(), so free cells can be sampled without scanning the world
+    long *free_rows;    // EMPTY cells in every row of chunks
+    long free_total;    // EMPTY cells in the whole world
+};
+
+
+/**
+ * Allocates new empty world.
+ * @param size dimensions of the world
+ * @returns pointer to the allocated world, NULL if memory could not be allocated
+ */
+struct world *world_create(const int size);
+
+
+/**
+ * Clears every cell of the world (frees all of its chunks), resizing it when dimensions differ.
+ * Chunk directory is reused if the size stays the same, its rows are then cleared by every worker of the pool.
+ * @param world world to reset
+ * @param size new dimensions of the world
+ * @param pool threads clearing the world, NULL clears it on the calling thread
+ * @returns 0 if everything ok, 1 if memory could not be allocated (world is left untouched)
+ */
+int world_reset(struct world *world, const int size, struct pool *pool);
+
+
+/**
+ * Frees world & all of its cells.
+ * @param world world to free (NULL is allowed)
+ */
+void world_destroy(struct world *world);
+
+
+/**
+ * Finds entity index stored in the side table.
+ * @attention cell at the given position needs to be marked with ENTITY_CELL
+ * @param pos row-major position of the cell
+ * @returns entity index (without ENTITY_START offset)
+ */
+int world_entity(const struct world *world, const long pos);
+
+
+/**
+ * Writes single cell of the world.
+ * Chunk of the cell is allocated when needed & freed when it becomes empty.
+ * @attention row & col need to be inside the world bounds
+ * @attention out of memory for a new chunk is fatal, the world would be inconsistent otherwise
+ * @param value EMPTY, blob color or ENTITY_START + entity index
+ */
+void world_set(struct world *world, const int row, const int col, const int value);
+
+
+/**
+ * Copies whole chunk into the empty world, eg. when loading saved world.
+ * Cells marked with ENTITY_CELL need to be set by world_set() afterwards, so that they get into the side table.
+ * @param index row-major index of the chunk
+ * @param chunk content of the chunk
+ * @returns 0 if everything ok, 1 if the chunk already exists or memory could not be allocated
+ */
+int world_chunk_load(struct world *world, const long index, const struct chunk *chunk);
+
+
+/**
+ * Tests whether a box of cells is completely empty.
+ * Occupancy bitmap is tested a whole chunk row at once (64 cells), missing chunks are skipped.
+ * @attention box needs to be inside the world bounds
+ * @param top first row of the box
+ * @param left first col of the box
+ * @param bottom last row of the box (included)
+ * @param right last col of the box (included)
+ * @returns true if every cell of the box is EMPTY, false otherwise
+ */
+bool world_box_empty(const struct world *world, const int top, const int left, const int bottom, const int right);
+
+
+/**
+ * Finds free (EMPTY) cell with the given ordinal number.
+ * Row of chunks & chunk are found by their free counts, inside the chunk only its occupancy bitmap is counted.
+ * Uniformly random free cell is found for uniformly random index.
+ * @param index ordinal number of the free cell in row-major order of chunks, from 0 to world->free_total - 1
+ * @param row pointer to store row of found cell
+ * @param col pointer to store col of found cell
+ * @returns true if cell was found, false if index is out of range
+ */
+bool world_free_cell(const struct world *world, long index, int *row, int *col);
+
+
+/**
+ * Finds the nearest blob within the given distance.
+ * Only buckets containing blobs are searched, from the nearest ones outwards.
+ * @param row 'y' coordinate of query point
+ * @param col 'x' coordinate of query point
+ * @param radius maximum distance of found blob
+ * @param blob_row pointer to store row of found blob
+ * @param blob_col pointer to store col of found blob
+ * @returns true if blob was found, false otherwise
+ */
+bool world_nearest_blob(const struct world *world, const int row, const int col, const float radius, int *blob_row, int *blob_col);
+
+
+/**
+ * Reads single cell of the world.
+ * @attention row & col need to be inside the world bounds
+ * @returns EMPTY, blob color or ENTITY_START + entity index
+ */
+static inline int world_get(const struct world *world, const int row, const int col)
+{
+    const struct chunk *chunk = world->chunks[(long)(row / CHUNK) * world->chunk_cols + col / CHUNK];
+    if (chunk == NULL)
+        return EMPTY;
+
+    int cell = chunk->cells[(row % CHUNK) * CHUNK + col % CHUNK];
+    return cell == ENTITY_CELL ? ENTITY_START + world_entity(world, (long)row * world->size + col) : cell;
+}
+
+
+#endif